@@ -0,0 +1,771 @@
+#include "../macro_tokenizer.hpp"
+#include "../macro_parser.hpp"
+#include "../keyword_table.hpp"
+#include "../hash_table.hpp"
+#include "../directory_walker.hpp"
+#include "../file_graph.hpp"
+#include "../graph_snapshot.hpp"
+#include "../file_prefetcher.hpp"
+#include "../work_stealing_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../utilities.hpp"
+
+#if defined(__linux__)
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+using namespace std::literals;	// For string literal suffix (conversion to std::string_view)
+
+/*
+	Benchmarks of the hot parts of the tool.
+	They run on files of given folders (recursively) or on a generated source if there is none.
+
+	Usage: benchmarks [folder or file]...
+*/
+
+static const size_t	generated_source_nb_functions = 20000;
+
+static std::string generate_source()
+{
+	std::string	source;
+
+	source += "/// Generated source\n";
+	for (size_t i = 0; i < 64; i++) {
+		source += "#include \"header_" + std::to_string(i) + ".hpp\"\n";
+	}
+	for (size_t i = 0; i < generated_source_nb_functions; i++)
+	{
+		source += "/* Function " + std::to_string(i) + " */\n";
+		source += "static int function_" + std::to_string(i) + "(const std::vector<int>& values, int factor)\n";
+		source += "{\n";
+		source += "\tint result = 0; // accumulator\n";
+		source += "\tfor (size_t index = 0; index < values.size(); index++) {\n";
+		source += "\t\tresult += values[index] * factor + 'a' - (int)\"text\"[index % 4];\n";
+		source += "\t}\n";
+		source += "\treturn result;\n";
+		source += "}\n";
+	}
+	return source;
+}
+
+static std::vector<fs::path> list_input_files(int ac, char** av)
+{
+	std::vector<fs::path>	paths;
+
+	for (int i = 1; i < ac; i++)
+	{
+		if (fs::is_directory(av[i])) {
+			for (const auto& entry : fs::recursive_directory_iterator(av[i])) {
+				if (entry.is_regular_file()) {
+					paths.push_back(entry.path());
+				}
+			}
+		}
+		else {
+			paths.push_back(av[i]);
+		}
+	}
+	return paths;
+}
+
+static std::vector<fs::path> list_input_directories(int ac, char** av)
+{
+	std::vector<fs::path>	directories;
+
+	for (int i = 1; i < ac; i++)
+	{
+		if (fs::is_directory(av[i])) {
+			directories.push_back(av[i]);
+		}
+	}
+	return directories;
+}
+
+static std::vector<std::string> load_inputs(const std::vector<fs::path>& paths)
+{
+	std::vector<std::string>	inputs;
+
+	for (const fs::path& path : paths)
+	{
+		inputs.emplace_back();
+		if (read_all_file(path, inputs.back()) == false) {
+			std::cerr << "Error: Failed to read the file " << path << "." << std::endl;
+			inputs.pop_back();
+		}
+	}
+
+	if (inputs.empty()) {
+		inputs.push_back(generate_source());
+	}
+	return inputs;
+}
+
+static size_t inputs_size(const std::vector<std::string>& inputs)
+{
+	size_t	size = 0;
+
+	for (const std::string& input : inputs) {
+		size += input.size();
+	}
+	return size;
+}
+
+/// Memory used by tokens per byte of input, with the tokens vector (before the Token_Stream) and the Token_Stream
+static void benchmark_tokens_memory(const std::vector<std::string>& inputs)
+{
+	const size_t	tokens_length_heuristic = 6;	// Same reserve than the tokenizer
+	size_t			nb_tokens = 0;
+	size_t			vector_memory = 0;
+	size_t			stream_memory = 0;
+	size_t			directives_stream_memory = 0;
+
+	for (const std::string& input : inputs)
+	{
+		macro::Token_Stream			tokens;
+		macro::Token_Stream			directive_tokens;
+		std::vector<macro::Token>	tokens_vector;
+
+		macro::tokenize(input, tokens);
+		macro::tokenize(input, directive_tokens, macro::Tokenize_Mode::directives);
+
+		tokens_vector.reserve(input.length() / tokens_length_heuristic);
+		for (const macro::Token& token : tokens) {
+			tokens_vector.push_back(token);
+		}
+
+		nb_tokens += tokens.size();
+		vector_memory += tokens_vector.capacity() * sizeof(macro::Token);
+		stream_memory += tokens.memory_usage();
+		directives_stream_memory += directive_tokens.memory_usage();
+	}
+
+	double	input_size = (double)inputs_size(inputs);
+
+	std::cout << "Tokens memory (" << nb_tokens << " tokens for " << inputs_size(inputs) << " bytes)" << std::endl;
+	std::cout << "\t" "std::vector<Token>: " << vector_memory << " bytes - " << (double)vector_memory / input_size << " bytes per input byte" << std::endl;
+	std::cout << "\t" "Token_Stream: " << stream_memory << " bytes - " << (double)stream_memory / input_size << " bytes per input byte" << std::endl;
+	std::cout << "\t" "Token_Stream (directives): " << directives_stream_memory << " bytes - " << (double)directives_stream_memory / input_size << " bytes per input byte" << std::endl;
+	std::cout << std::endl;
+}
+
+/// Previous implementation of read_all_file (zero filled string and a copy of the file)
+static bool read_all_file_with_ifstream(const fs::path& file_path, std::string& data)
+{
+	std::ifstream   file(file_path, std::fstream::binary);
+	std::streampos  file_size;
+
+	if (file.is_open() == false) {
+		return false;
+	}
+
+	file.seekg(0, file.end);
+	file_size = file.tellg();
+	file.seekg(0, file.beg);
+
+	data.resize((size_t)file_size);
+	file.read(reinterpret_cast<char*>(data.data()), data.size());
+	return file.fail() == false;
+}
+
+/// Time to read files and to find their directives
+/// @Warning files are in the system cache after the first pass, so this doesn't measure a cold scan
+static void benchmark_file_reading(const std::vector<fs::path>& paths)
+{
+	if (paths.empty()) {
+		return;
+	}
+
+	size_t	default_threshold = File_View::mapping_threshold;
+	size_t	nb_mapped_files = 0;
+
+	auto run = [&paths](const auto& read_file) -> std::chrono::duration<double> {
+		size_t	nb_tokens = 0;
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (const fs::path& path : paths)
+		{
+			std::string_view	content;
+
+			if (read_file(path, content))
+			{
+				macro::Lexer	lexer(content, macro::Tokenize_Mode::directives);
+				macro::Token	token;
+
+				while (lexer.next(token)) {
+					nb_tokens++;
+				}
+			}
+		}
+		return std::chrono::high_resolution_clock::now() - start;
+	};
+
+	std::string	buffer;
+	File_View	file;
+
+	auto ifstream_duration = run([&buffer](const fs::path& path, std::string_view& content) {
+		bool result = read_all_file_with_ifstream(path, buffer);
+		content = buffer;
+		return result;
+	});
+	auto file_view = [&file, &nb_mapped_files](const fs::path& path, std::string_view& content) {
+		bool result = file.open(path);
+		content = file.view();
+		nb_mapped_files += file.is_mapped();
+		return result;
+	};
+
+	File_View::mapping_threshold = std::numeric_limits<size_t>::max();
+	auto buffered_duration = run(file_view);
+	File_View::mapping_threshold = 0;
+	auto mapped_duration = run(file_view);
+	File_View::mapping_threshold = default_threshold;
+	nb_mapped_files = 0;
+	auto default_duration = run(file_view);
+
+	double	nb_files = (double)paths.size();
+
+	std::cout << "File reading + directives (" << paths.size() << " files, " << nb_mapped_files << " mapped with the default threshold)" << std::endl;
+	std::cout << "\t" "std::ifstream: " << ifstream_duration.count() << "s - " << ifstream_duration.count() * 1000000.0 / nb_files << " us per file" << std::endl;
+	std::cout << "\t" "File_View buffered: " << buffered_duration.count() << "s - " << buffered_duration.count() * 1000000.0 / nb_files << " us per file" << std::endl;
+	std::cout << "\t" "File_View mapped: " << mapped_duration.count() << "s - " << mapped_duration.count() * 1000000.0 / nb_files << " us per file" << std::endl;
+	std::cout << "\t" "File_View (threshold " << default_threshold << " bytes): " << default_duration.count() << "s - " << default_duration.count() * 1000000.0 / nb_files << " us per file" << std::endl;
+	std::cout << std::endl;
+}
+
+/// Remove files from the system cache to measure cold reads, return false if it isn't supported
+static bool evict_files_from_cache(const std::vector<fs::path>& paths)
+{
+#if defined(__linux__)
+	for (const fs::path& path : paths)
+	{
+		int	file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+		if (file >= 0)
+		{
+			posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED);
+			close(file);
+		}
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
+/// Time to read files and to find their directives with each prefetch backend
+/// The next files are prefetched while a file is parsed, like includes found in a file
+static void benchmark_prefetching(const std::vector<fs::path>& paths)
+{
+	const size_t		prefetch_distance = 64;
+	const char*			backend_names[] = {"synchronous", "thread pool", "io_uring"};
+
+	if (paths.empty()) {
+		return;
+	}
+
+	bool	cold = evict_files_from_cache(paths);
+	size_t	expected_nb_tokens = 0;
+
+	std::cout << "Prefetching (" << paths.size() << " files, " << (cold ? "cold cache" : "warm cache") << ")" << std::endl;
+	for (Prefetch_Backend backend : {Prefetch_Backend::synchronous, Prefetch_Backend::thread_pool, Prefetch_Backend::io_uring})
+	{
+		if (is_prefetch_backend_supported(backend) == false) {
+			continue;
+		}
+
+		evict_files_from_cache(paths);
+
+		File_Prefetcher	prefetcher(backend);
+		File_View		file;
+		size_t			nb_tokens = 0;
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < paths.size(); i++)
+		{
+			for (size_t next = i + 1; next < paths.size() && next <= i + prefetch_distance; next++) {
+				prefetcher.prefetch(paths[next]);
+			}
+
+			if (prefetcher.open(paths[i], file))
+			{
+				macro::Lexer	lexer(file.view(), macro::Tokenize_Mode::directives);
+				macro::Token	token;
+
+				while (lexer.next(token)) {
+					nb_tokens++;
+				}
+			}
+		}
+		std::chrono::duration<double>	duration = std::chrono::high_resolution_clock::now() - start;
+
+		std::cout << "\t" << backend_names[(size_t)backend] << ": " << duration.count() << "s - " << duration.count() * 1000000.0 / (double)paths.size() << " us per file"
+			<< " - " << prefetcher.stats().nb_hits << " files prefetched"
+			<< (backend == Prefetch_Backend::synchronous || nb_tokens == expected_nb_tokens ? "" : " (Error: different tokens)") << std::endl;
+		if (backend == Prefetch_Backend::synchronous) {
+			expected_nb_tokens = nb_tokens;
+		}
+	}
+	std::cout << std::endl;
+}
+
+/// Throughput of the full tokenization and of the directives fast path
+static void benchmark_tokenizer(const std::vector<std::string>& inputs)
+{
+	size_t	nb_tokens = 0;
+	size_t	nb_directives_tokens = 0;
+
+	auto all_tokens_start = std::chrono::high_resolution_clock::now();
+	for (const std::string& input : inputs)
+	{
+		macro::Lexer	lexer(input);
+		macro::Token	token;
+
+		while (lexer.next(token)) {
+			nb_tokens++;
+		}
+	}
+	auto all_tokens_end = std::chrono::high_resolution_clock::now();
+
+	auto directives_start = std::chrono::high_resolution_clock::now();
+	for (const std::string& input : inputs)
+	{
+		macro::Lexer	lexer(input, macro::Tokenize_Mode::directives);
+		macro::Token	token;
+
+		while (lexer.next(token)) {
+			nb_directives_tokens++;
+		}
+	}
+	auto directives_end = std::chrono::high_resolution_clock::now();
+
+	std::chrono::duration<double>	all_tokens_duration = all_tokens_end - all_tokens_start;
+	std::chrono::duration<double>	directives_duration = directives_end - directives_start;
+	double							input_size = (double)inputs_size(inputs) / (1024.0 * 1024.0);
+
+	std::cout << "Tokenizer" << std::endl;
+	std::cout << "\t" "All tokens: " << all_tokens_duration.count() << "s - " << input_size / all_tokens_duration.count() << " MB/s - " << nb_tokens << " tokens" << std::endl;
+	std::cout << "\t" "Directives: " << directives_duration.count() << "s - " << input_size / directives_duration.count() << " MB/s - " << nb_directives_tokens << " tokens" << std::endl;
+	std::cout << std::endl;
+}
+
+/// Punctuations of 2 characters in a table built the runtime way (a flat table of all 16 bits keys, filled by its constructor
+/// at startup) or in the constexpr sparse table of the tokenizer (in read only data, nothing is built at startup)
+template<typename Table>
+static std::unique_ptr<Table> build_punctuation_table_2()
+{
+	using macro::Punctuation;
+
+	return std::make_unique<Table>(std::initializer_list<std::pair<uint16_t, Punctuation>>{
+		{punctuation_key_2("//"), Punctuation::line_comment},
+		{punctuation_key_2("/*"), Punctuation::open_block_comment},
+		{punctuation_key_2("*/"), Punctuation::close_block_comment},
+		{punctuation_key_2("->"), Punctuation::arrow},
+		{punctuation_key_2("&&"), Punctuation::logical_and},
+		{punctuation_key_2("||"), Punctuation::logical_or},
+		{punctuation_key_2("::"), Punctuation::double_colon},
+		{punctuation_key_2("=="), Punctuation::equality_test},
+		{punctuation_key_2("!="), Punctuation::difference_test},
+	});
+}
+
+/// Construction time, size and lookup throughput (every pair of adjacent characters of inputs) of the punctuation table of
+/// 2 characters, built at runtime as a flat table (what the tokenizer did at startup) and as the constexpr sparse table
+static void benchmark_punctuation_tables(const std::vector<std::string>& inputs)
+{
+	using Flat_Table = Hash_Table<uint16_t, macro::Punctuation, macro::Punctuation::unknown>;
+	using Sparse_Table = std::remove_const_t<decltype(macro::Language_Definition::punctuation_table_2)>;
+
+	static constexpr size_t	nb_constructions = 100;
+
+	const Sparse_Table&	constexpr_table = macro::Language_Definition::punctuation_table_2;
+	size_t				nb_checked_keys = 0;	// Keeps tables built by the loops
+	size_t				nb_flat_punctuations = 0;
+	size_t				nb_sparse_punctuations = 0;
+	size_t				nb_lookups = 0;
+
+	auto flat_construction_start = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < nb_constructions; i++) {
+		nb_checked_keys += (*build_punctuation_table_2<Flat_Table>())[punctuation_key_2("::")] != macro::Punctuation::unknown;
+	}
+	auto flat_construction_end = std::chrono::high_resolution_clock::now();
+
+	auto sparse_construction_start = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < nb_constructions; i++) {
+		nb_checked_keys += (*build_punctuation_table_2<Sparse_Table>())[punctuation_key_2("::")] != macro::Punctuation::unknown;
+	}
+	auto sparse_construction_end = std::chrono::high_resolution_clock::now();
+
+	std::unique_ptr<Flat_Table>	flat_table = build_punctuation_table_2<Flat_Table>();
+
+	auto flat_lookups_start = std::chrono::high_resolution_clock::now();
+	for (const std::string& input : inputs)
+	{
+		for (size_t i = 0; i + 1 < input.size(); i++) {
+			nb_flat_punctuations += (*flat_table)[punctuation_key_2(input.data() + i)] != macro::Punctuation::unknown;
+		}
+		nb_lookups += input.empty() ? 0 : input.size() - 1;
+	}
+	auto flat_lookups_end = std::chrono::high_resolution_clock::now();
+
+	auto sparse_lookups_start = std::chrono::high_resolution_clock::now();
+	for (const std::string& input : inputs)
+	{
+		for (size_t i = 0; i + 1 < input.size(); i++) {
+			nb_sparse_punctuations += constexpr_table[punctuation_key_2(input.data() + i)] != macro::Punctuation::unknown;
+		}
+	}
+	auto sparse_lookups_end = std::chrono::high_resolution_clock::now();
+
+	std::chrono::duration<double>	flat_construction_duration = flat_construction_end - flat_construction_start;
+	std::chrono::duration<double>	sparse_construction_duration = sparse_construction_end - sparse_construction_start;
+	std::chrono::duration<double>	flat_lookups_duration = flat_lookups_end - flat_lookups_start;
+	std::chrono::duration<double>	sparse_lookups_duration = sparse_lookups_end - sparse_lookups_start;
+	double							millions_of_lookups = (double)nb_lookups / 1000000.0;
+
+	std::cout << "Punctuation table of 2 characters (" << nb_lookups << " lookups)" << std::endl;
+	std::cout << "\t" "Flat table built at runtime: " << 1000000.0 * flat_construction_duration.count() / (double)nb_constructions << "us per construction - "
+		<< (double)Flat_Table::memory_usage() / 1024.0 << " KB - Lookups: " << flat_lookups_duration.count() << "s - " << millions_of_lookups / flat_lookups_duration.count() << " M lookups/s - "
+		<< nb_flat_punctuations << " punctuations" << std::endl;
+	std::cout << "\t" "Sparse table built at runtime: " << 1000000.0 * sparse_construction_duration.count() / (double)nb_constructions << "us per construction - "
+		<< (double)Sparse_Table::memory_usage() / 1024.0 << " KB" << std::endl;
+	std::cout << "\t" "Constexpr sparse table (not built at startup): " << (double)Sparse_Table::memory_usage() / 1024.0 << " KB - Lookups: " << sparse_lookups_duration.count() << "s - "
+		<< millions_of_lookups / sparse_lookups_duration.count() << " M lookups/s - " << nb_sparse_punctuations << " punctuations"
+		<< (nb_sparse_punctuations == nb_flat_punctuations && nb_checked_keys == 2 * nb_constructions ? "" : " (Error: different results)") << std::endl;
+	std::cout << std::endl;
+}
+
+/// Time to extract includes with the tokens stored then parsed, and with the fused Lexer/parser
+static void benchmark_includes_parsing(const std::vector<std::string>& inputs)
+{
+	size_t	nb_includes = 0;
+	size_t	nb_fused_includes = 0;
+
+	auto two_phases_start = std::chrono::high_resolution_clock::now();
+	for (const std::string& input : inputs)
+	{
+		macro::Token_Stream			tokens;
+		macro::Macro_Parsing_Result	parsing_result;
+
+		macro::tokenize(input, tokens, macro::Tokenize_Mode::directives);
+		macro::parse_macros(tokens, parsing_result);
+		nb_includes += parsing_result.includes.size();
+	}
+	auto two_phases_end = std::chrono::high_resolution_clock::now();
+
+	auto fused_start = std::chrono::high_resolution_clock::now();
+	for (const std::string& input : inputs)
+	{
+		macro::Lexer	lexer(input, macro::Tokenize_Mode::directives);
+
+		macro::parse_macros(lexer, [&nb_fused_includes](const macro::Include&) { nb_fused_includes++; });
+	}
+	auto fused_end = std::chrono::high_resolution_clock::now();
+
+	std::chrono::duration<double>	two_phases_duration = two_phases_end - two_phases_start;
+	std::chrono::duration<double>	fused_duration = fused_end - fused_start;
+	double							input_size = (double)inputs_size(inputs) / (1024.0 * 1024.0);
+
+	std::cout << "Includes parsing (" << nb_includes << " includes)" << std::endl;
+	std::cout << "\t" "tokenize + parse_macros: " << two_phases_duration.count() << "s - " << input_size / two_phases_duration.count() << " MB/s" << std::endl;
+	std::cout << "\t" "Lexer fused with the parser: " << fused_duration.count() << "s - " << input_size / fused_duration.count() << " MB/s"
+		<< (nb_fused_includes == nb_includes ? "" : " (Error: different number of includes)") << std::endl;
+	std::cout << std::endl;
+}
+
+/// Throughput of the keyword lookup on every identifier of inputs (what the tokenizer did before keywords
+/// were only looked for after a '#'), with a std::unordered_map and with the constexpr perfect hash
+static void benchmark_keywords_classification(const std::vector<std::string>& inputs)
+{
+	using macro::Keyword;
+
+	static const std::unordered_map<std::string_view, Keyword>	keywords_map = {
+		{"include"sv, Keyword::_include}, {"define"sv, Keyword::_define}, {"undef"sv, Keyword::_undef}, {"pragma"sv, Keyword::_pragma},
+		{"if"sv, Keyword::_if}, {"else"sv, Keyword::_else}, {"elif"sv, Keyword::_elif}, {"endif"sv, Keyword::_endif},
+		{"ifdef"sv, Keyword::_ifdef}, {"ifndef"sv, Keyword::_ifndef}, {"defined"sv, Keyword::_defined}, {"error"sv, Keyword::_error},
+	};
+	static constexpr auto	keywords_table = make_keyword_table<Keyword>({
+		{"include"sv, Keyword::_include}, {"define"sv, Keyword::_define}, {"undef"sv, Keyword::_undef}, {"pragma"sv, Keyword::_pragma},
+		{"if"sv, Keyword::_if}, {"else"sv, Keyword::_else}, {"elif"sv, Keyword::_elif}, {"endif"sv, Keyword::_endif},
+		{"ifdef"sv, Keyword::_ifdef}, {"ifndef"sv, Keyword::_ifndef}, {"defined"sv, Keyword::_defined}, {"error"sv, Keyword::_error},
+	});
+
+	std::vector<std::string_view>	identifiers;
+	size_t							nb_identifiers = 0;
+	size_t							nb_map_keywords = 0;
+	size_t							nb_table_keywords = 0;
+	size_t							nb_context_keywords = 0;
+	std::chrono::duration<double>	map_duration(0);
+	std::chrono::duration<double>	table_duration(0);
+
+	for (const std::string& input : inputs)
+	{
+		macro::Lexer	lexer(input);
+		macro::Token	token;
+
+		identifiers.clear();
+		while (lexer.next(token))
+		{
+			if (token.punctuation == macro::Punctuation::unknown) {
+				identifiers.push_back(token.text);
+			}
+			if (token.keyword != Keyword::_unknown) {
+				nb_context_keywords++;
+			}
+		}
+		nb_identifiers += identifiers.size();
+
+		auto map_start = std::chrono::high_resolution_clock::now();
+		for (std::string_view identifier : identifiers)
+		{
+			auto it = keywords_map.find(identifier);
+			nb_map_keywords += (it != keywords_map.end() && it->second != Keyword::_unknown);
+		}
+		auto map_end = std::chrono::high_resolution_clock::now();
+
+		auto table_start = std::chrono::high_resolution_clock::now();
+		for (std::string_view identifier : identifiers) {
+			nb_table_keywords += keywords_table.find(identifier) != Keyword::_unknown;
+		}
+		auto table_end = std::chrono::high_resolution_clock::now();
+
+		map_duration += map_end - map_start;
+		table_duration += table_end - table_start;
+	}
+
+	double	millions_of_identifiers = (double)nb_identifiers / 1000000.0;
+
+	std::cout << "Keywords classification (" << nb_identifiers << " identifiers)" << std::endl;
+	std::cout << "\t" "std::unordered_map: " << map_duration.count() << "s - " << millions_of_identifiers / map_duration.count() << " M identifiers/s - " << nb_map_keywords << " keywords" << std::endl;
+	std::cout << "\t" "Keyword_Table: " << table_duration.count() << "s - " << millions_of_identifiers / table_duration.count() << " M identifiers/s - " << nb_table_keywords << " keywords"
+		<< (nb_table_keywords == nb_map_keywords ? "" : " (Error: different number of keywords)") << std::endl;
+	std::cout << "\t" "Classified by the tokenizer (directive names and defined in conditions): " << nb_context_keywords << " keywords" << std::endl;
+	std::cout << std::endl;
+}
+
+/// Scaling of the scan of files (read + tokenize + parse) on the work stealing pool, from 1 thread to the number of hardware threads
+/// This is the part of the graph generation that runs in parallel, the graph is then linked serially
+static void benchmark_parallel_scan(const std::vector<fs::path>& paths)
+{
+	size_t							max_nb_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	std::vector<size_t>				threads_counts;
+	std::chrono::duration<double>	serial_duration(0);
+
+	for (size_t nb_threads = 1; nb_threads < max_nb_threads; nb_threads *= 2) {
+		threads_counts.push_back(nb_threads);
+	}
+	threads_counts.push_back(max_nb_threads);
+
+	std::cout << "Parallel scan (" << paths.size() << " files, " << max_nb_threads << " hardware threads)" << std::endl;
+	for (size_t nb_threads : threads_counts)
+	{
+		std::atomic<size_t>	nb_includes{0};
+
+		auto start = std::chrono::high_resolution_clock::now();
+		{
+			Work_Stealing_Pool		pool(nb_threads);
+			std::vector<File_View>	files(pool.nb_threads());
+
+			for (const fs::path& path : paths)
+			{
+				pool.submit([&files, &nb_includes, &path]() {
+					File_View&	file = files[Work_Stealing_Pool::current_thread_index()];
+
+					if (file.open(path) == false) {
+						return;
+					}
+
+					macro::Lexer	lexer(file.view(), macro::Tokenize_Mode::directives);
+					size_t			nb_file_includes = 0;
+
+					macro::parse_macros(lexer, [&nb_file_includes](const macro::Include&) { nb_file_includes++; });
+					nb_includes += nb_file_includes;
+					file.close();
+				});
+			}
+			pool.wait();
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+
+		std::chrono::duration<double>	duration = end - start;
+
+		if (nb_threads == 1) {
+			serial_duration = duration;
+		}
+		std::cout << "	" << nb_threads << (nb_threads > 1 ? " threads: " : " thread: ") << duration.count() << "s - " << (double)paths.size() / duration.count() << " files/s"
+			<< " - Speedup: " << serial_duration.count() / duration.count() << "x - " << nb_includes << " includes" << std::endl;
+	}
+	std::cout << std::endl;
+}
+
+/// The walker alone (every file is accepted), compared to recursive_directory_iterator that the tool used before
+static void benchmark_directory_walker(const std::vector<fs::path>& directories)
+{
+	size_t							max_nb_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	std::vector<size_t>				threads_counts;
+	std::chrono::duration<double>	iterator_duration(0);
+	size_t							nb_iterator_entries = 0;
+
+	if (directories.empty()) {
+		std::cout << "Directory walker: no input directory" << std::endl << std::endl;
+		return;
+	}
+
+	for (size_t nb_threads = 1; nb_threads < max_nb_threads; nb_threads *= 2) {
+		threads_counts.push_back(nb_threads);
+	}
+	threads_counts.push_back(max_nb_threads);
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (const fs::path& directory : directories)
+	{
+		std::error_code	error;
+
+		for (fs::recursive_directory_iterator it(directory, error), end; !error && it != end; it.increment(error))
+		{
+			nb_iterator_entries++;
+			it->is_regular_file(error);	// What the tool asked for each entry
+			error.clear();
+		}
+	}
+	iterator_duration = std::chrono::high_resolution_clock::now() - start;
+
+	std::cout << "Directory walker (" << directories.size() << " directories, " << max_nb_threads << " hardware threads)" << std::endl;
+	std::cout << "	recursive_directory_iterator: " << iterator_duration.count() << "s - " << (double)nb_iterator_entries / iterator_duration.count() << " entries/s - "
+		<< nb_iterator_entries << " entries" << std::endl;
+	for (size_t nb_threads : threads_counts)
+	{
+		Directory_Walker			walker(nb_threads);
+		std::vector<std::string>	files;
+
+		for (const fs::path& directory : directories) {
+			walker.walk(directory, nullptr, nullptr, files);
+		}
+
+		const Directory_Walker::Stats&	stats = walker.stats();
+
+		std::cout << "	" << nb_threads << (nb_threads > 1 ? " threads: " : " thread: ") << stats.duration << "s - " << (double)stats.nb_entries / stats.duration << " entries/s"
+			<< " - Speedup: " << iterator_duration.count() / stats.duration << "x - " << stats.nb_entries << " entries in " << stats.nb_directories << " directories" << std::endl;
+	}
+	std::cout << std::endl;
+}
+
+/// Reverse reachability from a few headers on a generated graph of the size of a big code base
+/// Sources are the first nodes, each node includes nodes created after it (headers are deeper in the graph)
+static void benchmark_impact_query()
+{
+	static const size_t	nb_sources = 100000;
+	static const size_t	nb_nodes = 500000;
+	static const size_t	nb_includes_per_node = 8;
+	static const size_t	nb_changed_headers = 16;
+	static const size_t	nb_queries = 10;
+
+	Arena			arena;
+	File_Graph		graph(arena);
+	uint64_t		seed = 0x9E3779B97F4A7C15;
+	auto			random = [&seed]() { seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17; return seed; };	// xorshift64
+
+	for (size_t node = 0; node < nb_nodes; node++) {
+		graph.add_node(0, 0, 0, node < nb_sources ? File_Type::source : File_Type::header, true);
+	}
+	for (size_t node = 0; node + 1 < nb_nodes; node++)
+	{
+		for (size_t i = 0; i < nb_includes_per_node; i++) {
+			graph.add_edge((Node_Id)node, (Node_Id)(std::max(node + 1, nb_sources) + random() % (nb_nodes - std::max(node + 1, nb_sources))));
+		}
+	}
+
+	auto freeze_start = std::chrono::high_resolution_clock::now();
+	graph.freeze();
+	std::chrono::duration<double>	freeze_duration = std::chrono::high_resolution_clock::now() - freeze_start;
+
+	std::chrono::duration<double>	query_duration(0);
+	size_t							nb_reached = 0;
+	std::vector<Node_Id>			changed;
+	std::vector<Node_Id>			reached;
+
+	for (size_t query = 0; query < nb_queries; query++)
+	{
+		changed.clear();
+		reached.clear();
+		for (size_t i = 0; i < nb_changed_headers; i++) {
+			changed.push_back((Node_Id)(nb_nodes - 1 - random() % (nb_nodes / 10)));	// Deep headers, included by many files
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+		graph.ancestors(changed, reached);
+		query_duration += std::chrono::high_resolution_clock::now() - start;
+		nb_reached += reached.size();
+	}
+
+	std::cout << "Impact query (" << nb_nodes << " nodes, " << graph.nb_edges() << " edges, " << nb_changed_headers << " changed headers)" << std::endl;
+	std::cout << "	Freeze: " << freeze_duration.count() << "s - " << (double)graph.memory_usage() / (1024.0 * 1024.0) << " MB" << std::endl;
+	std::cout << "	Query: " << query_duration.count() / (double)nb_queries << "s - " << nb_reached / nb_queries << " nodes reached" << std::endl;
+
+	// The same query from a snapshot, loading it doesn't depend on the size of the graph
+	std::vector<Node_Texts>	texts(graph.nb_nodes(), Node_Texts{"generated.h", "generated.h"});	// The path of all nodes
+	Graph_Snapshot			snapshot;
+	fs::path				snapshot_path = fs::temp_directory_path() / "incg_benchmark.graph";
+
+	if (Graph_Snapshot::save(snapshot_path, graph, texts, std::vector<Node_Id>()) == false) {
+		std::cout << "	Snapshot: unable to write " << snapshot_path << std::endl << std::endl;
+		return;
+	}
+
+	auto load_start = std::chrono::high_resolution_clock::now();
+	bool loaded = snapshot.load(snapshot_path);
+	std::chrono::duration<double>	load_duration = std::chrono::high_resolution_clock::now() - load_start;
+
+	if (loaded)
+	{
+		reached.clear();
+
+		auto snapshot_query_start = std::chrono::high_resolution_clock::now();
+		snapshot.ancestors(changed, reached);
+		std::chrono::duration<double>	snapshot_query_duration = std::chrono::high_resolution_clock::now() - snapshot_query_start;
+
+		std::cout << "	Snapshot: " << (double)fs::file_size(snapshot_path) / (1024.0 * 1024.0) << " MB - Load: " << load_duration.count() << "s"
+			<< " - First query (pages read on demand): " << snapshot_query_duration.count() << "s - " << reached.size() << " nodes reached" << std::endl;
+	}
+	snapshot.close();
+	fs::remove(snapshot_path);
+	std::cout << std::endl;
+}
+
+int main(int ac, char** av)
+{
+	std::vector<fs::path>		paths = list_input_files(ac, av);
+	std::vector<std::string>	inputs = load_inputs(paths);
+
+	std::cout << std::fixed << std::setprecision(3);
+
+	benchmark_prefetching(paths);
+	benchmark_file_reading(paths);
+	benchmark_parallel_scan(paths);
+	benchmark_directory_walker(list_input_directories(ac, av));
+	benchmark_impact_query();
+
+	benchmark_tokenizer(inputs);
+	benchmark_punctuation_tables(inputs);
+	benchmark_tokens_memory(inputs);
+	benchmark_includes_parsing(inputs);
+	benchmark_keywords_classification(inputs);
+
+	return 0;
+}
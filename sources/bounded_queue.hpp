@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// Lock free queue of a fixed capacity, for many producers and many consumers
+/// Each cell has a sequence number that tells if it is free for the producer of a position or filled for the consumer
+/// of a position, so producers and consumers only compete on their own position counter (one compare and swap per operation)
+/// try_push fails when the queue is full, callers wait (backpressure) or keep the value for later
+/// @Warning the capacity is rounded up to a power of 2
+template<typename T>
+class Bounded_Queue
+{
+public:
+	explicit Bounded_Queue(size_t capacity)
+	{
+		size_t	rounded_capacity = 2;
+
+		while (rounded_capacity < capacity) {
+			rounded_capacity *= 2;
+		}
+		m_cells.reset(new Cell[rounded_capacity]);
+		m_mask = rounded_capacity - 1;
+		for (size_t i = 0; i < rounded_capacity; i++) {
+			m_cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	Bounded_Queue(const Bounded_Queue&) = delete;
+	Bounded_Queue&	operator=(const Bounded_Queue&) = delete;
+
+	/// Return false if the queue is full (value is left untouched)
+	bool	try_push(T& value)
+	{
+		size_t	position = m_push_position.load(std::memory_order_relaxed);
+
+		while (true)
+		{
+			Cell&		cell = m_cells[position & m_mask];
+			size_t		sequence = cell.sequence.load(std::memory_order_acquire);
+			intptr_t	difference = (intptr_t)sequence - (intptr_t)position;
+
+			if (difference == 0)
+			{
+				if (m_push_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					cell.value = std::move(value);
+					cell.sequence.store(position + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (difference < 0) {
+				return false;	// The cell still holds the value pushed one lap before
+			}
+			else {
+				position = m_push_position.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/// Return false if the queue is empty
+	bool	try_pop(T& value)
+	{
+		size_t	position = m_pop_position.load(std::memory_order_relaxed);
+
+		while (true)
+		{
+			Cell&		cell = m_cells[position & m_mask];
+			size_t		sequence = cell.sequence.load(std::memory_order_acquire);
+			intptr_t	difference = (intptr_t)sequence - (intptr_t)(position + 1);
+
+			if (difference == 0)
+			{
+				if (m_pop_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					value = std::move(cell.value);
+					cell.sequence.store(position + m_mask + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (difference < 0) {
+				return false;
+			}
+			else {
+				position = m_pop_position.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/// Approximation when other threads push or pop at the same time
+	size_t	size() const
+	{
+		size_t	push_position = m_push_position.load(std::memory_order_relaxed);
+		size_t	pop_position = m_pop_position.load(std::memory_order_relaxed);
+
+		return push_position > pop_position ? push_position - pop_position : 0;
+	}
+
+	size_t	capacity() const { return m_mask + 1; }
+
+private:
+	struct Cell
+	{
+		std::atomic<size_t>	sequence;
+		T					value;
+	};
+
+	std::unique_ptr<Cell[]>			m_cells;
+	size_t							m_mask;
+	alignas(64) std::atomic<size_t>	m_push_position{0};		// @Warning on their own cache line, producers and consumers don't share it
+	alignas(64) std::atomic<size_t>	m_pop_position{0};
+};
@@ -1,63 +1,208 @@
 #include "cpp_includes_graph.hpp"
 
+#include "directory_index.hpp"
+#include "directory_walker.hpp"
+#include "file_graph.hpp"
+#include "file_prefetcher.hpp"
+#include "file_watcher.hpp"
+#include "graph_snapshot.hpp"
+#include "bounded_queue.hpp"
+#include "path_table.hpp"
+#include "scan_cache_file.hpp"
+#include "work_stealing_pool.hpp"
 #include "macro_tokenizer.hpp"
 #include "macro_parser.hpp"
 
 #include "utilities.hpp"
 
-#include <algorithm>	// std::transform std::to_lower
+#include <algorithm>	// std::min std::max
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
+#include <functional>
 #include <iostream>		// std::cout
+#include <mutex>
+#include <sstream>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 
 namespace fs = std::filesystem;
 
-enum class File_Type {
-	not_supported,
-	source,
-	header
+/// Includes with the same spelling written in files of the same directory are resolved to the same header
+struct Include_Resolution_Key {
+	Path_Id				directory;
+	uint32_t			source_folder_index;	// Labels of headers found relatively to the parent are based on the source folder
+	std::string_view	spelling;				// @Warning interned, compared by address
+	macro::Include_Type	type;
+
+	bool	operator==(const Include_Resolution_Key& other) const
+	{
+		return directory == other.directory
+			&& source_folder_index == other.source_folder_index
+			&& spelling.data() == other.spelling.data()
+			&& spelling.length() == other.spelling.length()
+			&& type == other.type;
+	}
+};
+
+struct Include_Resolution_Key_Hash {
+	size_t	operator()(const Include_Resolution_Key& key) const
+	{
+		size_t	hash = std::hash<const char*>()(key.spelling.data());
+
+		hash ^= (size_t)((uint64_t)key.directory << 32 | (uint64_t)key.source_folder_index << 2 | (uint64_t)key.type) + (size_t)0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+		return hash;
+	}
+};
+
+/// A negative result (file not found) is kept too, the search isn't done again
+struct Include_Resolution {
+	Path_Id		label;
+	Path_Id		header_path;
+	bool		file_found;
+	Node_Id		node = invalid_node_id;	// Set once the node of the header is created or found
+};
+
+constexpr uint32_t	no_scan = UINT32_MAX;
+
+/// Result of the scan of a physical file, shared by all nodes whose path leads to it
+struct File_Scan {
+	Path_Id		path = invalid_path_id;	// First path found for the file, the one that is prefetched and read
+	bool		scanned = false;
+	bool		scanning = false;	// By a thread of the parallel scan
+	bool		consumed = false;	// The first node of the project that scanned the file took the scan (the next ones reuse it)
+	const incg::Project*	scanned_by = nullptr;
+	uint32_t	first_include = 0;	// In Scan_Cache::scanned_includes
+	uint32_t	nb_includes = 0;
+	size_t		nb_lines = 0;
+	bool		has_identity = false;	// Only scans of files with an identity (and a version) are saved in scan cache files
+	File_Identity	identity = {0, 0};
+	File_Version	version = {0, 0};
+};
+
+/// Files scanned by all projects of the configuration, headers shared by projects (include directories) are read once
+/// Each project builds its own graph over these scans
+struct Scan_Cache {
+	std::mutex									mutex;				// Held by a project while it builds its graph (projects run concurrently)
+	Path_Table									paths;				// Labels, paths and directories of files
+	String_Arena								include_spellings;	// Includes as written in files (the content of files isn't kept)
+	std::vector<File_Scan>						scans;				// A physical file is scanned once even if it has many paths (and many nodes)
+	std::vector<uint32_t>						path_scans;			// Index of the scan by Path_Id of file paths
+	std::unordered_map<File_Identity, uint32_t, File_Identity_Hash>	scan_by_identity;
+	std::vector<macro::Include>					scanned_includes;	// Includes of all scans
+	Directory_Index								directory_index;	// Entries of source folders and include directories of all projects, a root is enumerated once
 };
 
-struct File_Node {
-	std::string				unique_name;
-	std::string				label;			// Relative header_path
-	fs::path				path;
-	File_Type				file_type;
-	std::vector<File_Node*>	parents;
-	std::vector<File_Node*>	children;
-	bool					printed = false;	// @Warning to avoid duplicates in the dot file and to break recursivity (cycle inclusion)
-	bool					file_found;
-	size_t					nb_inclusions = 0;
-	size_t					nb_lines = 0;
-	std::string				__string_views_buffer;
+/// Activity of a stage of the scan pipeline, to find the bottleneck on a given machine
+struct Stage_Report {
+	const char*	name;
+	size_t		nb_threads = 0;
+	size_t		nb_items = 0;
+	double		busy_duration = 0.0;		// In seconds, summed over threads of the stage
+	double		blocked_duration = 0.0;		// Waiting for room in the queue of the next stage (backpressure)
+	double		idle_duration = 0.0;		// Waiting for items
+	size_t		queue_capacity = 0;			// Of the input queue (0 for the walker)
+	double		average_queue_size = 0.0;	// Sampled at each pop
+	size_t		max_queue_size = 0;
+	size_t		max_backlog_size = 0;		// Requests kept by the resolver while the queue of readers is full
 };
 
+using Include_Resolutions = std::unordered_map<Include_Resolution_Key, Include_Resolution, Include_Resolution_Key_Hash, std::equal_to<Include_Resolution_Key>,
+	Arena_Allocator<std::pair<const Include_Resolution_Key, Include_Resolution>>>;
+
+/// @Warning a project result lives as long as the project, its arena is released at once at the end
 struct Project_Result {
+	Arena										arena;				// @Warning first, members that use it are destroyed before it
 	const incg::Project*						project;
-	std::vector<File_Node*>						root_nodes;			// Every source file is a root node
-	std::unordered_map<std::string, File_Node*>	nodes;				// All nodes by name
+	std::vector<Node_Id>						root_nodes;			// Every source file is a root node
+	Scan_Cache*									scan_cache;			// Shared by all projects of the configuration
+	File_Graph									graph{arena};		// Frozen once all includes are followed
+	std::vector<Node_Id>						nodes;				// First node of each label by label id (invalid for ids that aren't labels)
+	Scan_Mode									scan_mode = Scan_Mode::serial;
+	size_t										nb_threads = 1;		// Of the pool or of each parallel stage of the pipeline
+	std::vector<Stage_Report>					pipeline_stages;
+	std::chrono::duration<double>				duration = std::chrono::duration<double>::zero();
+	std::chrono::duration<double>				scan_cache_wait_duration = std::chrono::duration<double>::zero();	// Other projects were building their graph
+	File_View									file;				// Reused to read every file of the project
+	std::unique_ptr<File_Prefetcher>			prefetcher;			// Reads files of the project in background, only for the serial scan (other scans read files on their own threads)
+	Directory_Index::Lookup_Stats				index_lookups;		// In the directory index of the scan cache
+	Directory_Walker							source_walker;		// Lists sources of source folders
+	std::chrono::duration<double>				include_resolution_duration = std::chrono::duration<double>::zero();
+	std::vector<fs::path>						sources_folders;		// Absolute paths, computed once from the project
+	std::vector<fs::path>						include_directories;	// Absolute paths, computed once from the project
+	Include_Resolutions							include_resolutions{0, Include_Resolution_Key_Hash(), std::equal_to<Include_Resolution_Key>(), Arena_Allocator<Include_Resolution>(arena)};
+	std::vector<macro::Include>					include_stack;		// Includes of nodes being generated, reused by the recursion
+	std::vector<Include_Resolution*>			resolution_stack;	// Resolutions of includes of include_stack
+	size_t										nb_resolution_hits = 0;
+	size_t										nb_resolution_misses = 0;
+	size_t										nb_scans = 0;
+	size_t										nb_reused_scans = 0;	// Files already scanned under another path or by another project
+	bool										use_scan_cache_file = true;
+	Scan_Cache_File								scan_cache_file;		// Scans of the previous run of the project
+	std::vector<macro::Include>					cached_includes;		// Includes of a scan found in the scan cache file, reused
+	size_t										nb_cached_scans = 0;	// Scans loaded from the scan cache file instead of reading files
+	std::vector<Path_Id>*						watched_directories = nullptr;	// Only for the watch mode, directories whose changes affect the project
+	std::vector<std::string>					walked_directories;		// Directories of source folders, listed only for the watch mode
+	const std::vector<std::string>*				changed_files = nullptr;	// Only for the impact query
+	std::ostream*								impact_output = nullptr;	// Sources to rebuild, one path per line
 };
 
-std::unordered_set<std::string>	header_extensions = {
-	".h",
-	".hpp",
-	".hxx",
-	".inl",
-	".impl",
+/// Key of an extension of up to 4 characters (without the dot), characters are lower cased by setting their bit 0x20
+/// (among letters it only changes upper case ones), 0 if there is no extension or if it is longer
+constexpr uint32_t extension_key(std::string_view extension)
+{
+	uint32_t	key = 0;
+
+	for (size_t i = 0; i < extension.length() && i < 4; i++) {
+		key |= (uint32_t)((uint8_t)extension[i] | 0x20) << (8 * i);
+	}
+	return extension.length() <= 4 ? key : 0;
+}
+
+constexpr uint32_t	header_extension_keys[] = {
+	extension_key("h"),
+	extension_key("hpp"),
+	extension_key("hxx"),
+	extension_key("inl"),
+	extension_key("impl"),
 };
 
-std::unordered_set<std::string>	source_extensions = {
-	".c",
-	".cpp",
-	".cxx",
+constexpr uint32_t	source_extension_keys[] = {
+	extension_key("c"),
+	extension_key("cpp"),
+	extension_key("cxx"),
 };
 
-static std::string get_unique_name(const Project_Result& result)
+/// Same extension as std::filesystem::path::extension (a leading dot isn't an extension), without allocation nor table lookup
+/// The key is compared to all extensions at once, the results are combined without branch
+constexpr File_Type get_file_type(std::string_view file_name)
+{
+	size_t		dot_position = file_name.rfind('.');
+	uint32_t	key = (dot_position == std::string_view::npos || dot_position == 0) ? 0 : extension_key(file_name.substr(dot_position + 1));
+	uint32_t	is_header = 0;
+	uint32_t	is_source = 0;
+
+	for (uint32_t header_key : header_extension_keys) {
+		is_header |= (uint32_t)(key == header_key);
+	}
+	for (uint32_t source_key : source_extension_keys) {
+		is_source |= (uint32_t)(key == source_key);
+	}
+	return (File_Type)(is_header * (uint32_t)File_Type::header | is_source * (uint32_t)File_Type::source);	// @Warning extensions of headers and sources are different
+}
+
+static_assert(get_file_type("main.cpp") == File_Type::source && get_file_type("MAIN.CXX") == File_Type::source && get_file_type("a.b.c") == File_Type::source);
+static_assert(get_file_type("tokenizer.hpp") == File_Type::header && get_file_type("Types.H") == File_Type::header && get_file_type("file.impl") == File_Type::header);
+static_assert(get_file_type(".h") == File_Type::not_supported && get_file_type("main.cpp.txt") == File_Type::not_supported && get_file_type("file.hpp2") == File_Type::not_supported);
+static_assert(get_file_type("no_extension") == File_Type::not_supported && get_file_type("file.") == File_Type::not_supported && get_file_type("file.implementation") == File_Type::not_supported);
+
+static std::string get_unique_name(uint32_t node_index)
 {
-	size_t		seed = result.nodes.size();
+	size_t		seed = node_index;
 	std::string	unique;
 
 	do
@@ -71,195 +216,1074 @@ static std::string get_unique_name(const Project_Result& result)
 	return unique;
 }
 
-static File_Type get_file_type(const fs::path& file_path)
+static Node_Id find_node(const Project_Result& result, Path_Id label)
 {
-	std::string extension = file_path.extension().string();
+	return label < result.nodes.size() ? result.nodes[label] : invalid_node_id;
+}
+
+static Node_Id create_node(Project_Result& result, Path_Id label, Path_Id path, File_Type file_type, bool file_found)
+{
+	Path_Id	directory = result.scan_cache->paths.intern(fs::path(result.scan_cache->paths.path(path)).parent_path().generic_string());
+	Node_Id	node = result.graph.add_node(label, path, directory, file_type, file_found);
+
+	if (result.nodes.size() <= label) {
+		result.nodes.resize(result.scan_cache->paths.size(), invalid_node_id);
+	}
+	if (result.nodes[label] == invalid_node_id) {	// @Warning the first node of a label is kept
+		result.nodes[label] = node;
+	}
+	return node;
+}
 
-	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
-	if (header_extensions.find(extension) != header_extensions.end()) {
-		return File_Type::header;
+/// Return the index of the scan of the physical file of the path
+/// The file is identified by its device and inode, or by its canonical path if the system doesn't give them
+static uint32_t get_file_scan(Project_Result& result, Path_Id path)
+{
+	Scan_Cache&	cache = *result.scan_cache;
+
+	if (path < cache.path_scans.size() && cache.path_scans[path] != no_scan) {
+		return cache.path_scans[path];
 	}
-	if (source_extensions.find(extension) != source_extensions.end()) {
-		return File_Type::source;
+
+	fs::path		file_path = cache.paths.path(path);
+	File_Identity	identity;
+	File_Version	version;
+	bool			has_identity = get_file_identity(file_path, identity, &version);
+
+	if (has_identity == false)
+	{
+		std::error_code	error;
+		fs::path		canonical_path = fs::canonical(file_path, error);
+
+		identity.device = UINT64_MAX;
+		identity.file = error ? path : cache.paths.intern(canonical_path.generic_string());
 	}
 
-	return File_Type::not_supported;
+	auto	it = cache.scan_by_identity.try_emplace(identity, (uint32_t)cache.scans.size());
+
+	if (it.second)
+	{
+		File_Scan	scan;
+		size_t		nb_lines = 0;
+
+		scan.path = path;
+
+		scan.has_identity = has_identity;
+		scan.identity = identity;
+		scan.version = version;
+
+		// An unchanged file isn't read again, its scan is in the scan cache file of the previous run
+		result.cached_includes.clear();
+		if (has_identity && result.scan_cache_file.find(identity, version, result.cached_includes, nb_lines))
+		{
+			scan.scanned = true;
+			scan.scanned_by = result.project;
+			scan.first_include = (uint32_t)cache.scanned_includes.size();
+			scan.nb_includes = (uint32_t)result.cached_includes.size();
+			scan.nb_lines = nb_lines;
+			for (const macro::Include& include : result.cached_includes) {
+				cache.scanned_includes.push_back({include.type, cache.include_spellings.intern(include.path)});	// @Warning the cache file is closed at the end of the project
+			}
+			result.nb_cached_scans++;
+		}
+		cache.scans.push_back(scan);
+	}
+	if (cache.path_scans.size() <= path) {
+		cache.path_scans.resize(cache.paths.size(), no_scan);
+	}
+	cache.path_scans[path] = it.first->second;
+	return it.first->second;
 }
 
-static void get_includes(File_Node* node, std::vector<std::string_view>& includes)
+/// Return the scan of the file, or no_scan if it wasn't scanned (it isn't added)
+static uint32_t find_file_scan(const Scan_Cache& cache, const fs::path& file_path)
 {
-	std::vector<macro::Token>	tokens;
-	macro::Macro_Parsing_Result	parsing_result;
+	File_Identity	identity;
 
-	if (read_all_file(node->path, node->__string_views_buffer) == false) {
-		return;
+	if (get_file_identity(file_path, identity) == false)
+	{
+		std::error_code	error;
+		fs::path		canonical_path = fs::canonical(file_path, error);
+		Path_Id			path = error ? invalid_path_id : cache.paths.find(canonical_path.generic_string());
+
+		if (path == invalid_path_id) {
+			return no_scan;
+		}
+		identity.device = UINT64_MAX;
+		identity.file = path;
 	}
 
-	tokenize(node->__string_views_buffer, tokens);
-	parse_macros(tokens, parsing_result);
+	auto	it = cache.scan_by_identity.find(identity);
 
-	if (tokens.size()) {
-		node->nb_lines = tokens.back().line;
+	return it != cache.scan_by_identity.end() ? it->second : no_scan;
+}
+
+/// Keep includes (with interned spellings) of a file that was just scanned, for other paths of the file and other projects
+static void store_scan(Project_Result& result, uint32_t scan_index, const macro::Include* includes, size_t nb_includes, size_t nb_lines, bool consumed)
+{
+	Scan_Cache&	cache = *result.scan_cache;
+	File_Scan&	scan = cache.scans[scan_index];
+
+	result.nb_scans++;
+	scan.scanned = true;
+	scan.scanning = false;
+	scan.consumed = consumed;
+	scan.scanned_by = result.project;
+	scan.first_include = (uint32_t)cache.scanned_includes.size();
+	scan.nb_includes = (uint32_t)nb_includes;
+	scan.nb_lines = nb_lines;
+	cache.scanned_includes.insert(cache.scanned_includes.end(), includes, includes + nb_includes);
+}
+
+/// Append includes of the file of the node
+static void get_includes(Node_Id node, Project_Result& result, std::vector<macro::Include>& includes)
+{
+	Scan_Cache&			cache = *result.scan_cache;
+	size_t				first_include = includes.size();
+	Node_Attributes&	attributes = result.graph.attributes(node);
+	uint32_t			scan_index = attributes.file_found ? get_file_scan(result, result.graph.paths(node).path) : no_scan;
+	Path_Id				path = result.graph.paths(node).path;
+
+	if (scan_index != no_scan)
+	{
+		File_Scan&	scan = cache.scans[scan_index];
+
+		if (scan.scanned)	// Scanned in parallel for this node, or the same file under another path, or scanned by another project
+		{
+			includes.insert(includes.end(), cache.scanned_includes.begin() + scan.first_include, cache.scanned_includes.begin() + scan.first_include + scan.nb_includes);
+			attributes.nb_lines = (uint32_t)scan.nb_lines;
+			if (scan.scanned_by == result.project && scan.consumed == false) {
+				scan.consumed = true;
+			}
+			else {
+				result.nb_reused_scans++;
+			}
+			return;
+		}
+		path = scan.path;
 	}
 
-	includes.reserve(parsing_result.includes.size());
+	bool	opened = result.prefetcher ? result.prefetcher->open(cache.paths.path(path), result.file) : result.file.open(cache.paths.path(path));
+
+	if (opened == false) {
+		return;
+	}
+
+	macro::Lexer	lexer(result.file.view(), macro::Tokenize_Mode::directives);
 
 	// @TODO resolve macro conditions here
-	for (const macro::Include& include : parsing_result.includes) {
-		includes.push_back(include.path);
+	macro::parse_macros(lexer, [&includes, &cache](const macro::Include& include) {
+		includes.push_back({include.type, cache.include_spellings.intern(include.path)});
+	});
+
+	attributes.nb_lines = (uint32_t)lexer.nb_lines();
+	result.file.close();	// @Warning the buffer is reused for the next file, includes are copied in the arena
+
+	if (scan_index != no_scan) {
+		store_scan(result, scan_index, includes.data() + first_include, includes.size() - first_include, lexer.nb_lines(), true);
 	}
 }
 
 /// Return the full header_path if it is able to find it
 /// else return the include_path
-static bool get_include_path(const incg::Configuration& configuration, const incg::Project& project, const fs::path& source_folder, const File_Node* parent, const fs::path& include_path, fs::path& header_path, std::string& relative_path_with_parent)
+static bool get_include_path(Project_Result& result, const fs::path& source_folder, Path_Id parent_directory_id, const fs::path& include_path, fs::path& header_path, std::string& relative_path_with_parent)
 {
-	fs::path	parent_directory = parent->path.parent_path();
+	fs::path	parent_directory = result.scan_cache->paths.path(parent_directory_id);
 
 	// Relative to the parent header_path
 	header_path = parent_directory / include_path;
-	if (fs::exists(header_path)) {
+	if (result.scan_cache->directory_index.exists(header_path, result.index_lookups)) {
 		relative_path_with_parent = (source_folder.filename() / header_path.lexically_relative(source_folder)).generic_string();	// @Warning we put the base of source directory to avoid conflicts if there is many similar source trees with a different root
 		return true;
 	}
 
-	// Relative to a source directory
-	for (const fs::path& directory : project.sources_folders)
+	// Relative to a source directory, then to an include directory
+	for (const std::vector<fs::path>* directories : {&result.sources_folders, &result.include_directories})
 	{
-		fs::path	absolute_directory = directory;
-		if (absolute_directory.is_relative()) {
-			absolute_directory = configuration.base_path / directory;
+		for (const fs::path& absolute_directory : *directories)
+		{
+			header_path = absolute_directory / include_path;
+			if (result.scan_cache->directory_index.exists(header_path, result.index_lookups)) {
+				relative_path_with_parent = (absolute_directory.filename() / header_path.lexically_relative(absolute_directory)).generic_string();	// @Warning we put the base of source directory to avoid conflicts if there is many similar source trees with a different root
+				return true;
+			}
 		}
+	}
+
+	header_path = include_path;
+	relative_path_with_parent = include_path.generic_string();
+	return false;
+}
+
+static const char*	scan_mode_names[] = {
+	"serial",
+	"tasks",
+	"pipeline",
+};
+
+static const char*	prefetch_backend_names[] = {
+	"synchronous",
+	"thread pool",
+	"io_uring",
+};
+
+/// Return the resolution of the include, the search is done only the first time an include is seen from a directory
+static Include_Resolution& resolve_include(Project_Result& result, const fs::path& source_folder, uint32_t source_folder_index, Path_Id parent_directory, const macro::Include& include)
+{
+	Include_Resolution_Key	key = {parent_directory, source_folder_index, include.path, include.type};
+	auto					it = result.include_resolutions.try_emplace(key);
+	Include_Resolution&		resolution = it.first->second;
+
+	if (it.second == false) {
+		result.nb_resolution_hits++;
+		return resolution;
+	}
+
+	fs::path	header_path;
+	std::string	label;
 
-		header_path = absolute_directory / include_path;
-		if (fs::exists(header_path)) {
-			relative_path_with_parent = (absolute_directory.filename() / header_path.lexically_relative(absolute_directory)).generic_string();	// @Warning we put the base of source directory to avoid conflicts if there is many similar source trees with a different root
-			return true;
+	result.nb_resolution_misses++;
+	resolution.file_found = get_include_path(result, source_folder, parent_directory, include.path, header_path, label);
+	resolution.label = result.scan_cache->paths.intern(label);
+	resolution.header_path = result.scan_cache->paths.intern(header_path.generic_string());
+	return resolution;
+}
+
+/// Generate the node tree from the given node (basically add edges to the children of the node)
+/// Includes and resolutions of the node are pushed on stacks of the result, so nodes don't allocate their own buffers
+/// This is a recursive function
+static void generate_includes_graph(const fs::path& source_folder, uint32_t source_folder_index, Node_Id parent, Project_Result& result)
+{
+	size_t	first_include = result.include_stack.size();
+
+	get_includes(parent, result, result.include_stack);
+
+	size_t	last_include = result.include_stack.size();
+
+	// Resolve all includes first to read new headers in background while the first ones are parsed
+	auto	resolution_start = std::chrono::high_resolution_clock::now();
+
+	result.resolution_stack.resize(last_include);
+	for (size_t i = first_include; i < last_include; i++)
+	{
+		Include_Resolution&	resolution = resolve_include(result, source_folder, source_folder_index, result.graph.paths(parent).directory, result.include_stack[i]);
+
+		if (resolution.node == invalid_node_id)
+		{
+			resolution.node = find_node(result, resolution.label);	// The header can be known with another spelling or from another directory
+			if (resolution.node == invalid_node_id && resolution.file_found && result.prefetcher)
+			{
+				const File_Scan&	scan = result.scan_cache->scans[get_file_scan(result, resolution.header_path)];
+
+				if (scan.scanned == false) {
+					result.prefetcher->prefetch(result.scan_cache->paths.path(scan.path));
+				}
+			}
 		}
+		result.resolution_stack[i] = &resolution;
 	}
+	result.include_resolution_duration += std::chrono::high_resolution_clock::now() - resolution_start;
 
-	// Relative to an include directory
-	for (const fs::path& directory : project.include_directories)
+	for (size_t i = first_include; i < last_include; i++)
 	{
-		fs::path	absolute_directory = directory;
-		if (absolute_directory.is_relative()) {
-			absolute_directory = configuration.base_path / directory;
+		Include_Resolution*	resolution = result.resolution_stack[i];	// @Warning stacks grow in the recursion, they can move
+
+		if (resolution->node == invalid_node_id) {
+			resolution->node = find_node(result, resolution->label);	// Created by the recursion of a previous include
 		}
 
-		header_path = absolute_directory / include_path;
-		if (fs::exists(header_path)) {
-			relative_path_with_parent = (absolute_directory.filename() / header_path.lexically_relative(absolute_directory)).generic_string();	// @Warning we put the base of source directory to avoid conflicts if there is many similar source trees with a different root
-			return true;
+		if (resolution->node != invalid_node_id)	// No need to create the node as it already exist
+		{
+			result.graph.add_edge(parent, resolution->node);	// Simply link it to his new parent (inlcuder)
+		}
+		else
+		{
+			Node_Id	node = create_node(result, resolution->label, resolution->header_path, File_Type::header, resolution->file_found);
+
+			result.graph.add_edge(parent, node);
+
+			resolution->node = node;
+
+			generate_includes_graph(source_folder, source_folder_index, node, result);
 		}
 	}
 
-	header_path = include_path;
-	relative_path_with_parent = include_path.generic_string();
-	return false;
+	result.include_stack.resize(first_include);
+	result.resolution_stack.resize(first_include);
 }
 
-/// Generate the node tree from the given node (basically fill the children member of the node)
-/// This is a recursive function
-static void generate_includes_graph(const incg::Configuration& configuration, const incg::Project& project, const fs::path& source_folder, File_Node* parent, Project_Result& result)
+/// State of the parallel scan of a project
+/// Tasks are (file, source folder) pairs, labels of headers found relatively to their parent are based on the source folder
+/// @Warning the scan cache and resolutions are shared by tasks under the mutex, only reading and parsing files is done
+/// without the lock (it is most of the work)
+struct Parallel_Scan {
+	Parallel_Scan(Project_Result& result, Work_Stealing_Pool& pool)
+		: result(result), pool(pool), files(pool.nb_threads()), includes(pool.nb_threads())
+	{
+	}
+
+	Project_Result&								result;
+	Work_Stealing_Pool&							pool;
+	std::vector<File_View>						files;				// By thread of the pool
+	std::vector<std::vector<macro::Include>>	includes;			// By thread of the pool, reused for every file
+	std::mutex									mutex;
+	std::unordered_set<uint64_t>				submitted_tasks;	// Path_Id and source folder index
+	std::unordered_map<uint32_t, std::vector<uint64_t>>	waiting_tasks;	// By scan, tasks of other paths of a file being scanned
+};
+
+static void submit_scan_task(Parallel_Scan& parallel_scan, Path_Id path, uint32_t source_folder_index);
+
+/// Scan the file if it isn't scanned yet, then resolve its includes and submit tasks for new headers
+static void scan_task(Parallel_Scan& parallel_scan, Path_Id path, uint32_t source_folder_index)
+{
+	Project_Result&					result = parallel_scan.result;
+	Scan_Cache&						cache = *result.scan_cache;
+	std::unique_lock<std::mutex>	lock(parallel_scan.mutex);
+	uint32_t						scan_index = get_file_scan(result, path);
+
+	if (cache.scans[scan_index].scanning)	// Through another path of the file, this task is submitted again once it is done
+	{
+		parallel_scan.waiting_tasks[scan_index].push_back((uint64_t)path << 32 | source_folder_index);
+		return;
+	}
+
+	if (cache.scans[scan_index].scanned == false)
+	{
+		std::vector<macro::Include>&	includes = parallel_scan.includes[Work_Stealing_Pool::current_thread_index()];
+		std::string						file_path(cache.paths.path(cache.scans[scan_index].path));
+		File_View&						file = parallel_scan.files[Work_Stealing_Pool::current_thread_index()];
+		size_t							nb_lines = 0;
+
+		cache.scans[scan_index].scanning = true;
+		lock.unlock();
+
+		includes.clear();
+
+		if (file.open(file_path))
+		{
+			macro::Lexer	lexer(file.view(), macro::Tokenize_Mode::directives);
+
+			macro::parse_macros(lexer, [&includes](const macro::Include& include) {
+				includes.push_back(include);
+			});
+			nb_lines = lexer.nb_lines();
+		}
+
+		lock.lock();
+		for (macro::Include& include : includes) {
+			include.path = cache.include_spellings.intern(include.path);
+		}
+		file.close();	// @Warning after the copy of spellings
+		store_scan(result, scan_index, includes.data(), includes.size(), nb_lines, false);
+
+		auto	it = parallel_scan.waiting_tasks.find(scan_index);
+
+		if (it != parallel_scan.waiting_tasks.end())
+		{
+			for (uint64_t task : it->second) {
+				parallel_scan.pool.submit([&parallel_scan, task]() { scan_task(parallel_scan, (Path_Id)(task >> 32), (uint32_t)task); });
+			}
+			parallel_scan.waiting_tasks.erase(it);
+		}
+	}
+
+	const File_Scan&	scan = cache.scans[scan_index];
+	Path_Id				directory = cache.paths.intern(fs::path(cache.paths.path(path)).parent_path().generic_string());
+	const fs::path&		source_folder = result.sources_folders[source_folder_index];
+
+	for (uint32_t i = 0; i < scan.nb_includes; i++)
+	{
+		macro::Include				include = cache.scanned_includes[scan.first_include + i];
+		const Include_Resolution&	resolution = resolve_include(result, source_folder, source_folder_index, directory, include);
+
+		if (resolution.file_found) {
+			submit_scan_task(parallel_scan, resolution.header_path, source_folder_index);
+		}
+	}
+}
+
+/// @Warning called with the lock
+static void submit_scan_task(Parallel_Scan& parallel_scan, Path_Id path, uint32_t source_folder_index)
 {
-	std::vector<std::string_view>	includes;
+	uint64_t	task = (uint64_t)path << 32 | source_folder_index;
+
+	if (parallel_scan.submitted_tasks.insert(task).second) {
+		parallel_scan.pool.submit([&parallel_scan, path, source_folder_index]() { scan_task(parallel_scan, path, source_folder_index); });
+	}
+}
+
+/// Scan all files reachable from sources on a work stealing pool, then the graph is generated without reading files
+/// The graph stays the same as with a serial scan (nodes are created by the same depth-first traversal)
+static void scan_in_parallel(Project_Result& result, const std::vector<std::vector<Path_Id>>& source_paths)
+{
+	Work_Stealing_Pool	pool(result.nb_threads);
+	Parallel_Scan		parallel_scan(result, pool);
+
+	{
+		std::lock_guard<std::mutex>	lock(parallel_scan.mutex);
+
+		for (uint32_t source_folder_index = 0; source_folder_index < (uint32_t)source_paths.size(); source_folder_index++) {
+			for (Path_Id path : source_paths[source_folder_index]) {
+				submit_scan_task(parallel_scan, path, source_folder_index);
+			}
+		}
+	}
+	pool.wait();
+}
+
+//=============================================================================
+// Scan pipeline
+//=============================================================================
+
+/// A file to read, from the walker (a source) or from the resolver (a header found in a scanned file)
+struct Read_Request {
+	std::string	file_path;
+	Path_Id		path = invalid_path_id;	// Path of the node, invalid for sources given by the walker to the resolver (the walker doesn't use the path table)
+	uint32_t	source_folder_index = 0;
+	uint32_t	scan_index = no_scan;
+};
+
+struct Read_File {
+	Read_Request				request;
+	std::unique_ptr<File_View>	file;	// Null if the file can't be read
+};
+
+struct Parsed_File {
+	Read_Request				request;
+	std::unique_ptr<File_View>	file;		// Kept until spellings of includes are interned
+	std::vector<macro::Include>	includes;	// Views in the file
+	size_t						nb_lines = 0;
+};
+
+struct Stage_Counters {
+	std::atomic<size_t>		nb_items{0};
+	std::atomic<uint64_t>	busy{0};	// In nanoseconds
+	std::atomic<uint64_t>	blocked{0};
+	std::atomic<uint64_t>	idle{0};
+	std::atomic<size_t>		queue_size_sum{0};
+	std::atomic<size_t>		nb_queue_samples{0};
+	std::atomic<size_t>		max_queue_size{0};
+};
+
+static uint64_t elapsed_nanoseconds(std::chrono::steady_clock::time_point start)
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+/// Spin a bit then sleep, queues are lock free so there is nothing to wait on
+static void back_off(size_t& nb_attempts)
+{
+	if (nb_attempts++ < 64) {
+		std::this_thread::yield();
+	}
+	else {
+		std::this_thread::sleep_for(std::chrono::microseconds(50));
+	}
+}
+
+/// Push the item, waiting while the queue is full (the next stage is the bottleneck)
+template<typename T>
+static void push(Bounded_Queue<T>& queue, T& item, Stage_Counters& counters)
+{
+	if (queue.try_push(item)) {
+		return;
+	}
+
+	auto	start = std::chrono::steady_clock::now();
+	size_t	nb_attempts = 0;
+
+	while (queue.try_push(item) == false) {
+		back_off(nb_attempts);
+	}
+	counters.blocked += elapsed_nanoseconds(start);
+}
+
+/// Pop an item, waiting while the queue is empty, return false if stop() becomes true while waiting
+template<typename T, typename Stop_Function>
+static bool pop(Bounded_Queue<T>& queue, T& item, Stage_Counters& counters, Stop_Function stop)
+{
+	auto	start = std::chrono::steady_clock::now();
+	size_t	nb_attempts = 0;
+	size_t	queue_size = queue.size();
+
+	while (queue.try_pop(item) == false)
+	{
+		if (stop()) {
+			counters.idle += elapsed_nanoseconds(start);
+			return false;
+		}
+		back_off(nb_attempts);
+		queue_size = queue.size();
+	}
+	counters.idle += elapsed_nanoseconds(start);
+
+	counters.queue_size_sum += queue_size;
+	counters.nb_queue_samples++;
+	for (size_t max_size = counters.max_queue_size; queue_size > max_size && counters.max_queue_size.compare_exchange_weak(max_size, queue_size) == false; ) {
+	}
+	return true;
+}
+
+static Stage_Report make_stage_report(const char* name, size_t nb_threads, const Stage_Counters& counters, size_t queue_capacity)
+{
+	Stage_Report	report;
+
+	report.name = name;
+	report.nb_threads = nb_threads;
+	report.nb_items = counters.nb_items;
+	report.busy_duration = (double)counters.busy / 1e9;
+	report.blocked_duration = (double)counters.blocked / 1e9;
+	report.idle_duration = (double)counters.idle / 1e9;
+	report.queue_capacity = queue_capacity;
+	report.average_queue_size = counters.nb_queue_samples ? (double)counters.queue_size_sum / (double)counters.nb_queue_samples : 0.0;
+	report.max_queue_size = counters.max_queue_size;
+	return report;
+}
+
+/// Directories of version control systems are never walked, they can be huge and don't contain sources
+static bool is_walked_directory(std::string_view name)
+{
+	return name != ".git" && name != ".svn" && name != ".hg";
+}
+
+/// Append paths of sources of the folder, in the order of the file system
+static void list_sources(Project_Result& result, const fs::path& source_folder, std::vector<std::string>& source_paths)
+{
+	result.source_walker.walk(source_folder,
+		[](std::string_view name) { return get_file_type(name) == File_Type::source; },	// Headers are children of sources files
+		is_walked_directory,
+		source_paths,
+		result.watched_directories ? &result.walked_directories : nullptr);
+}
+
+/// Scan all files reachable from sources with a pipeline of stages connected by bounded lock free queues:
+///  - walker (1 thread): lists sources of source folders, and gives them to the resolver
+///  - readers (nb_threads): read files
+///  - lexers (nb_threads): tokenize and parse files
+///  - resolver (the calling thread): stores scans, resolves includes and requests the read of files that aren't scanned
+///    yet (sources and headers alike, a file of the scan cache or of the scan cache file is never read)
+/// Only the resolver uses the scan cache and the resolutions, so they need no lock
+/// Full queues block the stage that pushes (backpressure, files in memory are bounded), except the resolver that keeps
+/// its requests in a backlog, as it feeds the readers it would be a deadlock
+static void scan_with_pipeline(Project_Result& result, std::vector<std::vector<Path_Id>>& source_paths)
+{
+	static constexpr size_t	read_queue_capacity = 1024;
+	static constexpr size_t	parse_queue_capacity = 64;	// @Warning files are in memory in these queues
+	static constexpr size_t	resolve_queue_capacity = 64;
+
+	Scan_Cache&					cache = *result.scan_cache;
+	Bounded_Queue<Read_Request>	read_queue(read_queue_capacity);
+	Bounded_Queue<Read_File>	parse_queue(parse_queue_capacity);
+	Bounded_Queue<Parsed_File>	resolve_queue(resolve_queue_capacity);
+	Stage_Counters				walker_counters;
+	Stage_Counters				reader_counters;
+	Stage_Counters				lexer_counters;
+	Stage_Counters				resolver_counters;
+	std::atomic<size_t>			nb_requests_in_flight{0};	// Walked sources and read requests not handled by the resolver yet
+	std::atomic<bool>			walker_done{false};
+	std::atomic<bool>			stop{false};
+	std::vector<std::vector<std::string>>	walked_sources(result.sources_folders.size());
+	std::vector<std::thread>	threads;
+
+	threads.emplace_back([&]() {
+		for (uint32_t source_folder_index = 0; source_folder_index < (uint32_t)result.sources_folders.size(); source_folder_index++)
+		{
+			auto	start = std::chrono::steady_clock::now();
+			uint64_t	blocked = walker_counters.blocked;
+
+			list_sources(result, result.sources_folders[source_folder_index], walked_sources[source_folder_index]);	// Directories of the folder are read in parallel, then sources are streamed to the resolver
+			for (const std::string& source_path : walked_sources[source_folder_index])
+			{
+				Parsed_File	walked_source;	// Not read, the resolver requests the read only if the source isn't scanned
+
+				walked_source.request.file_path = source_path;
+				walked_source.request.source_folder_index = source_folder_index;
 
-	includes.reserve(64);
-	parent->children.reserve(64);
-	get_includes(parent, includes);
+				nb_requests_in_flight++;
+				walker_counters.nb_items++;
+				push(resolve_queue, walked_source, walker_counters);
+			}
+			walker_counters.busy += elapsed_nanoseconds(start) - (walker_counters.blocked - blocked);
+		}
+		walker_done = true;
+	});
 
-	for (const std::string_view& include : includes) 
+	for (size_t i = 0; i < result.nb_threads; i++)
 	{
-		std::string	label;
-		fs::path	header_path;
-		bool		file_found;
-		
-		file_found = get_include_path(configuration, project, source_folder, parent, include, header_path, label);
+		threads.emplace_back([&]() {
+			Read_Request	request;
+
+			while (pop(read_queue, request, reader_counters, [&stop]() { return stop.load(); }))
+			{
+				auto		start = std::chrono::steady_clock::now();
+				Read_File	read_file;
+
+				read_file.file = std::make_unique<File_View>();
+				if (read_file.file->open(request.file_path) == false) {
+					read_file.file.reset();
+				}
+				read_file.request = std::move(request);
+				reader_counters.nb_items++;
+				reader_counters.busy += elapsed_nanoseconds(start);
+				push(parse_queue, read_file, reader_counters);
+			}
+		});
+		threads.emplace_back([&]() {
+			Read_File	read_file;
+
+			while (pop(parse_queue, read_file, lexer_counters, [&stop]() { return stop.load(); }))
+			{
+				auto		start = std::chrono::steady_clock::now();
+				Parsed_File	parsed_file;
+
+				if (read_file.file)
+				{
+					macro::Lexer	lexer(read_file.file->view(), macro::Tokenize_Mode::directives);
+
+					macro::parse_macros(lexer, [&parsed_file](const macro::Include& include) {
+						parsed_file.includes.push_back(include);
+					});
+					parsed_file.nb_lines = lexer.nb_lines();
+				}
+				parsed_file.request = std::move(read_file.request);
+				parsed_file.file = std::move(read_file.file);
+				lexer_counters.nb_items++;
+				lexer_counters.busy += elapsed_nanoseconds(start);
+				push(resolve_queue, parsed_file, lexer_counters);
+			}
+		});
+	}
 
-		auto it = result.nodes.find(label);
+	// Resolver
+	std::unordered_set<uint64_t>							submitted_tasks;	// Path_Id and source folder index
+	std::unordered_map<uint32_t, std::vector<uint64_t>>	waiting_tasks;		// By scan, tasks of other paths of a file being read
+	std::deque<Read_Request>								backlog;
+	size_t													max_backlog_size = 0;
+	std::vector<uint64_t>									tasks;
+
+	// A task is expanded now if its file is scanned, once it is if it is being read through another path, else the read
+	// of the file is requested
+	auto submit = [&](uint64_t task) {
+		if (submitted_tasks.insert(task).second == false) {
+			return;
+		}
 
-		if (it != result.nodes.end())	// No need to create the node as it already exist
+		uint32_t	scan_index = get_file_scan(result, (Path_Id)(task >> 32));
+		File_Scan&	scan = cache.scans[scan_index];
+
+		if (scan.scanned) {
+			tasks.push_back(task);
+		}
+		else if (scan.scanning) {
+			waiting_tasks[scan_index].push_back(task);
+		}
+		else
+		{
+			Read_Request	request;
+
+			scan.scanning = true;
+			request.file_path = cache.paths.path(scan.path);
+			request.path = (Path_Id)(task >> 32);
+			request.source_folder_index = (uint32_t)task;
+			request.scan_index = scan_index;
+			nb_requests_in_flight++;
+			backlog.push_back(std::move(request));
+		}
+	};
+
+	// Resolve includes of tasks of scanned files, and of their includes that are already scanned
+	auto expand = [&]() {
+		while (tasks.empty() == false)
 		{
-			File_Node* node = it->second;
+			Path_Id			path = (Path_Id)(tasks.back() >> 32);
+			uint32_t		source_folder_index = (uint32_t)tasks.back();
+			const fs::path&	source_folder = result.sources_folders[source_folder_index];
+			uint32_t		scan_index = get_file_scan(result, path);
+			uint32_t		first_include = cache.scans[scan_index].first_include;	// @Warning scans can move, new ones are added by the loop
+			uint32_t		nb_includes = cache.scans[scan_index].nb_includes;
+			Path_Id			directory = cache.paths.intern(fs::path(cache.paths.path(path)).parent_path().generic_string());
+
+			tasks.pop_back();
+			for (uint32_t i = 0; i < nb_includes; i++)
+			{
+				macro::Include				include = cache.scanned_includes[first_include + i];
+				const Include_Resolution&	resolution = resolve_include(result, source_folder, source_folder_index, directory, include);
+
+				if (resolution.file_found) {
+					submit((uint64_t)resolution.header_path << 32 | source_folder_index);
+				}
+			}
+		}
+	};
+
+	// Waiting for files stops when requests of the backlog can be pushed, or when everything is scanned
+	auto stop_waiting = [&]() {
+		return (backlog.empty() == false && read_queue.size() < read_queue.capacity())
+			|| (walker_done && nb_requests_in_flight == 0);
+	};
+
+	while (true)
+	{
+		while (backlog.empty() == false && read_queue.try_push(backlog.front())) {
+			backlog.pop_front();
+		}
+		max_backlog_size = std::max(max_backlog_size, backlog.size());
+
+		Parsed_File	parsed_file;
 
-			node->nb_inclusions++;
-			node->parents.push_back(parent);
+		if (walker_done && nb_requests_in_flight == 0) {
+			break;
+		}
+		if (pop(resolve_queue, parsed_file, resolver_counters, stop_waiting) == false) {
+			continue;
+		}
 
-			parent->children.push_back(node);	// Simply link it to his new parent (inlcuder)
+		auto		start = std::chrono::steady_clock::now();
+		Path_Id		path = parsed_file.request.path;
+		uint32_t	scan_index = parsed_file.request.scan_index;
+
+		if (path == invalid_path_id)	// A source from the walker, not read yet
+		{
+			path = cache.paths.intern(parsed_file.request.file_path);
+			submit((uint64_t)path << 32 | parsed_file.request.source_folder_index);	// @Warning a source can also be included
 		}
 		else
 		{
-			File_Node*	node = new File_Node;
+			if (cache.scans[scan_index].scanned == false)	// Else it was read through another path at the same time
+			{
+				for (macro::Include& include : parsed_file.includes) {
+					include.path = cache.include_spellings.intern(include.path);
+				}
+				store_scan(result, scan_index, parsed_file.includes.data(), parsed_file.includes.size(), parsed_file.nb_lines, false);
+			}
+			parsed_file.file.reset();
+			tasks.push_back((uint64_t)path << 32 | parsed_file.request.source_folder_index);
+
+			auto	it = waiting_tasks.find(scan_index);
+
+			if (it != waiting_tasks.end())
+			{
+				tasks.insert(tasks.end(), it->second.begin(), it->second.end());
+				waiting_tasks.erase(it);
+			}
+		}
+		expand();
+
+		nb_requests_in_flight--;
+		resolver_counters.nb_items++;
+		resolver_counters.busy += elapsed_nanoseconds(start);
+	}
+
+	stop = true;
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	for (size_t source_folder_index = 0; source_folder_index < walked_sources.size(); source_folder_index++) {
+		for (const std::string& source_path : walked_sources[source_folder_index]) {
+			source_paths[source_folder_index].push_back(cache.paths.intern(source_path));
+		}
+	}
+
+	result.pipeline_stages.push_back(make_stage_report("Walker", 1, walker_counters, 0));
+	result.pipeline_stages.push_back(make_stage_report("Readers", result.nb_threads, reader_counters, read_queue.capacity()));
+	result.pipeline_stages.push_back(make_stage_report("Lexers", result.nb_threads, lexer_counters, parse_queue.capacity()));
+	result.pipeline_stages.push_back(make_stage_report("Resolver", 1, resolver_counters, resolve_queue.capacity()));
+	result.pipeline_stages.back().max_backlog_size = max_backlog_size;
+}
+
+/// Scans of files of the project to save for its next run, their includes are copied in includes (the scan cache is
+/// shared by projects, it can grow once it is unlocked)
+/// Return true if the scan cache file is up to date, nothing has to be saved
+static bool collect_saved_scans(const Project_Result& result, std::vector<Scan_Cache_File::Saved_Scan>& scans, std::vector<macro::Include>& includes)
+{
+	const Scan_Cache&		cache = *result.scan_cache;
+	std::vector<bool>		saved(cache.scans.size(), false);
+	std::vector<uint32_t>	scan_indices;
+	size_t					nb_includes = 0;
+	bool					is_up_to_date = true;
+
+	for (Node_Id node = 0; node < (Node_Id)result.graph.nb_nodes(); node++)
+	{
+		Path_Id	path = result.graph.paths(node).path;
+
+		if (result.graph.attributes(node).file_found == false
+			|| path >= cache.path_scans.size()
+			|| cache.path_scans[path] == no_scan
+			|| saved[cache.path_scans[path]]) {
+			continue;
+		}
+
+		const File_Scan&	scan = cache.scans[cache.path_scans[path]];
 
-			node->unique_name = get_unique_name(result);
-			node->label = label;
-			node->path = header_path;
-			node->file_type = File_Type::header;
-			node->file_found = file_found;
-			node->nb_inclusions++;
-			node->parents.push_back(parent);
+		saved[cache.path_scans[path]] = true;
+		if (scan.scanned == false || scan.has_identity == false) {
+			continue;
+		}
+		scan_indices.push_back(cache.path_scans[path]);
+		nb_includes += scan.nb_includes;
+		is_up_to_date = is_up_to_date && result.scan_cache_file.contains(scan.identity, scan.version);
+	}
+
+	includes.reserve(nb_includes);	// @Warning saved scans point in it, it can't grow after
+	for (uint32_t scan_index : scan_indices)
+	{
+		const File_Scan&	scan = cache.scans[scan_index];
+
+		scans.push_back({scan.identity, scan.version, scan.nb_lines, includes.data() + includes.size(), scan.nb_includes});
+		includes.insert(includes.end(), cache.scanned_includes.begin() + scan.first_include, cache.scanned_includes.begin() + scan.first_include + scan.nb_includes);	// Spellings are interned, they don't move
+	}
+	return is_up_to_date && scans.size() == result.scan_cache_file.size();
+}
+
+/// Directories of source folders, include directories, and directories of all found files of the graph, sorted
+/// A new file in one of them can be a new source, or a header that an include now finds (or finds elsewhere)
+/// @Warning directories of headers that aren't found (and don't exist yet) aren't watched
+static void list_watched_directories(Project_Result& result)
+{
+	std::vector<Path_Id>&	directories = *result.watched_directories;
+
+	directories.clear();
+	for (const std::string& directory : result.walked_directories) {
+		directories.push_back(result.scan_cache->paths.intern(directory));
+	}
+	for (const fs::path& directory : result.include_directories) {
+		directories.push_back(result.scan_cache->paths.intern(directory.generic_string()));
+	}
+	for (Node_Id node = 0; node < (Node_Id)result.graph.nb_nodes(); node++)
+	{
+		if (result.graph.attributes(node).file_found) {
+			directories.push_back(result.graph.paths(node).directory);
+		}
+	}
+	std::sort(directories.begin(), directories.end());
+	directories.erase(std::unique(directories.begin(), directories.end()), directories.end());
+}
+
+/// Print sources that include one of the changed files, directly or not (a changed source is its own impact), in
+/// result.impact_output, and counts of the query in output
+/// Changed files are matched by their identity, so any path of a file finds its nodes
+static void print_impact(const Project_Result& result, std::ostream& output)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	const Scan_Cache&		cache = *result.scan_cache;
+	const File_Graph&		graph = result.graph;
+	std::vector<bool>		changed_scans(cache.scans.size(), false);
+	std::vector<bool>		found_scans(cache.scans.size(), false);	// Changed files that are in the graph
+	std::vector<Node_Id>	changed_nodes;
+	std::vector<Node_Id>	reached;
+	std::vector<Node_Id>	sources;
+	size_t					nb_found_files = 0;
+
+	for (const std::string& file : *result.changed_files)
+	{
+		std::error_code	error;
+		fs::path		file_path = fs::absolute(file, error);
+		uint32_t		scan_index = error ? no_scan : find_file_scan(cache, file_path);
+
+		if (scan_index != no_scan) {
+			changed_scans[scan_index] = true;
+		}
+	}
+	for (Node_Id node = 0; node < (Node_Id)graph.nb_nodes(); node++)
+	{
+		Path_Id		path = graph.paths(node).path;
+		uint32_t	scan_index = graph.attributes(node).file_found && path < cache.path_scans.size() ? cache.path_scans[path] : no_scan;
+
+		if (scan_index == no_scan || changed_scans[scan_index] == false) {
+			continue;
+		}
+		changed_nodes.push_back(node);
+		if (found_scans[scan_index] == false) {
+			found_scans[scan_index] = true;
+			nb_found_files++;
+		}
+	}
 
-			parent->children.push_back(node);
+	graph.ancestors(changed_nodes, reached);
+	for (Node_Id node : reached)
+	{
+		if (graph.attributes(node).file_type == File_Type::source) {
+			sources.push_back(node);
+		}
+	}
+	std::sort(sources.begin(), sources.end());	// In the order of the graph
+
+	std::chrono::duration<double>	duration = std::chrono::high_resolution_clock::now() - start;
+
+	output << "\t" "Impact: " << result.changed_files->size() << " changed files - In the graph: " << nb_found_files << " (" << changed_nodes.size() << " nodes)"
+		<< " - Sources to rebuild: " << sources.size() << " / " << result.root_nodes.size() << " - Headers affected: " << reached.size() - sources.size()
+		<< " - Query: " << duration.count() << "s" << std::endl;
+	for (Node_Id node : sources) {
+		*result.impact_output << cache.paths.path(graph.paths(node).path) << '\n';
+	}
+}
 
-			result.nodes.insert(std::pair<std::string, File_Node*>(node->label, node));
+/// Answer the impact query from the graph snapshot of the last run of the project, without scanning its sources
+/// Changed files are matched by the name, then by the identity of files (by the path if one of them doesn't exist, a
+/// removed header for instance), so only files with the name of a changed file are stat
+/// Return false if there is no valid snapshot, the project has to be generated
+/// @Warning includes added or removed since the last run aren't known, the answer is for the graph of the last run
+static bool print_impact_from_snapshot(const incg::Project& project, const fs::path& output_folder, const std::vector<std::string>& changed_files, std::ostream& output, std::ostream& impact_output)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	struct Changed_File
+	{
+		fs::path		path;	// Absolute and normal
+		File_Identity	identity;
+		bool			has_identity;
+		bool			found;
+	};
+
+	fs::path													snapshot_filepath = output_folder / (std::string(project.name) + ".graph");
+	Graph_Snapshot												snapshot;
+	std::vector<Changed_File>									files(changed_files.size());
+	std::unordered_map<std::string, std::vector<Changed_File*>>	files_by_name;
+	std::vector<Node_Id>										changed_nodes;
+	std::vector<Node_Id>										reached;
+	std::vector<Node_Id>										sources;
+	size_t														nb_found_files = 0;
+
+	if (snapshot.load(snapshot_filepath) == false) {
+		return false;
+	}
 
-			generate_includes_graph(configuration, project, source_folder, node, result);
+	for (size_t i = 0; i < changed_files.size(); i++)
+	{
+		std::error_code	error;
+
+		files[i].path = fs::absolute(changed_files[i], error).lexically_normal();
+		files[i].has_identity = get_file_identity(files[i].path, files[i].identity);
+		files[i].found = false;
+		files_by_name[files[i].path.filename().string()].push_back(&files[i]);
+	}
+	for (Node_Id node = 0; node < (Node_Id)snapshot.nb_nodes(); node++)
+	{
+		std::string_view	path = snapshot.path(node);
+		auto				it = files_by_name.find(std::string(path.substr(path.find_last_of('/') + 1)));	// npos + 1 is 0
+
+		if (snapshot.attributes(node).file_found == false || it == files_by_name.end()) {
+			continue;
 		}
+
+		File_Identity	identity;
+		bool			has_identity = get_file_identity(fs::path(path), identity);
+
+		for (Changed_File* file : it->second)
+		{
+			if (file->has_identity && has_identity ? file->identity == identity : file->path == fs::path(path).lexically_normal())
+			{
+				changed_nodes.push_back(node);
+				if (file->found == false) {
+					file->found = true;
+					nb_found_files++;
+				}
+				break;
+			}
+		}
+	}
+
+	snapshot.ancestors(changed_nodes, reached);
+	for (Node_Id node : reached)
+	{
+		if (snapshot.attributes(node).file_type == File_Type::source) {
+			sources.push_back(node);
+		}
+	}
+	std::sort(sources.begin(), sources.end());	// In the order of the graph
+
+	std::chrono::duration<double>	duration = std::chrono::high_resolution_clock::now() - start;
+
+	output << "Project: " << project.name << std::endl;
+	output << std::fixed << std::setprecision(3);
+	output << "\t" "Impact: " << changed_files.size() << " changed files - In the graph: " << nb_found_files << " (" << changed_nodes.size() << " nodes)"
+		<< " - Sources to rebuild: " << sources.size() << " / " << snapshot.root_nodes().size() << " - Headers affected: " << reached.size() - sources.size()
+		<< " - Query: " << duration.count() << "s" << std::endl;
+	output << "\t" "Graph snapshot: " << snapshot_filepath.generic_string() << " (" << snapshot.nb_nodes() << " nodes - " << snapshot.nb_edges() << " edges), sources weren't scanned" << std::endl;
+	for (Node_Id node : sources) {
+		impact_output << snapshot.path(node) << '\n';
 	}
+	output << std::endl;
+	return true;
 }
 
 /// This is a recursive function
-static void print_node(std::ofstream& stream, File_Node* node)
+static void print_node(std::ofstream& stream, const std::vector<Node_Texts>& texts, const File_Graph& graph, std::vector<bool>& printed, Node_Id node)
 {
 	// @Warning to avoid duplicates in the dot file and to break recursivity (cycle inclusion)
 	{
-		if (node->printed) {
+		if (printed[node]) {
 			return;
 		}
-		node->printed = true;
+		printed[node] = true;
 	}
 
-	std::string border_color;
-	std::string background_color;
+	const Node_Attributes&	attributes = graph.attributes(node);
+	const char*				border_color;
+	const char*				background_color;
 
 	// https://www.graphviz.org/doc/info/colors.html
-	if (node->file_found) {
+	if (attributes.file_found) {
 		border_color = "black";
 	}
 	else {
 		border_color = "red";
 	}
 
-	if (node->file_type == File_Type::source) {
+	if (attributes.file_type == File_Type::source) {
 		background_color = "lightseagreen";
 	}
 	else {
 		background_color = "orange";
 	}
 
-	std::string label;
+	std::string	unique_name = get_unique_name(node);	// Ids are in creation order
 
-	if (node->file_type == File_Type::header) {
-		label += std::to_string(node->nb_inclusions) + "x\n";
+	// The label is written directly in the stream, without building a string per node
+	stream << "\t" << unique_name << " [label=\"";
+	if (attributes.file_type == File_Type::header) {
+		stream << graph.nb_inclusions(node) << "x\n";
 	}
-	label += node->label;
-	if (node->nb_lines) {
-		label += " (" + std::to_string(node->nb_lines) + " loc)";
+	stream << texts[node].label;
+	if (attributes.nb_lines) {
+		stream << " (" << attributes.nb_lines << " loc)";
 	}
-
-	stream << "\t" << node->unique_name << " [label=\"" << label << "\" shape=box, style=filled, color=" << border_color << ", fillcolor=" << background_color << "]" << std::endl;
-	for (File_Node* child_node : node->children) {
-		stream << "\t" << node->unique_name << " -> " << child_node->unique_name << std::endl;
-		print_node(stream, child_node);
+	stream << "\" shape=box, style=filled, color=" << border_color << ", fillcolor=" << background_color << "]" << std::endl;
+	for (Node_Id child_node : graph.children(node)) {
+		stream << "\t" << unique_name << " -> " << get_unique_name(child_node) << std::endl;
+		print_node(stream, texts, graph, printed, child_node);
 	}
 };
 
 // @TODO use dot as library instead as binary ?
-static void	generate_includes_graph(const incg::Configuration& configuration, const incg::Project& project, const fs::path& output_folder, Project_Result& result)
+/// Reports of the project are written to output, projects run concurrently
+static void	generate_includes_graph(const incg::Configuration& configuration, const incg::Project& project, const fs::path& output_folder, Project_Result& result, std::ostream& output)
 {
-	std::ofstream	dot_file;
-	std::string		dot_filepath;
-	std::string		png_filepath;
+	std::ofstream					dot_file;
+	std::string						dot_filepath;
+	std::string						png_filepath;
+	std::unique_lock<std::mutex>	scan_cache_lock(result.scan_cache->mutex, std::defer_lock);
+	fs::path						scan_cache_filepath;
+	size_t							nb_loaded_scans = 0;	// Entries of the scan cache file
+	bool							scan_cache_file_up_to_date = true;
+	bool							scan_cache_file_saved = false;
+	fs::path						snapshot_filepath;
+	bool							snapshot_saved = false;
+	std::chrono::duration<double>	snapshot_duration = std::chrono::duration<double>::zero();
+
+	// Copied from the scan cache before it is unlocked, outputs are written while other projects are scanned
+	std::vector<Node_Texts>						node_texts;
+	std::vector<Scan_Cache_File::Saved_Scan>	saved_scans;
+	std::vector<macro::Include>					saved_includes;
+	std::ostringstream							impact_report;
+	size_t										nb_physical_files = 0;
+	size_t										nb_paths = 0;
+	size_t										paths_memory_usage = 0;
+	size_t										include_spellings_memory_usage = 0;
+	Directory_Index::Stats						index_stats;
+	double										index_build_duration = 0.0;	// Of directories enumerated for this project
 
 	auto generating_dot_start = std::chrono::high_resolution_clock::now();
 	{
@@ -267,49 +1291,107 @@ static void	generate_includes_graph(const incg::Configuration& configuration, co
 		png_filepath = output_folder.generic_string() + "/" + std::string(project.name) + ".png";
 		dot_file.open(dot_filepath, std::fstream::out | std::fstream::binary);
 		if (dot_file.is_open() == false) {
-			std::cout << "Error: unable to open file " << dot_filepath << std::endl;
+			output << "Error: unable to open file " << dot_filepath << std::endl;
 			return;
 		}
 
-		std::cout << "Project: " << project.name << std::endl;
+		output << "Project: " << project.name << std::endl;
 
 		result.project = &project;
+		result.source_walker = Directory_Walker(result.scan_mode == Scan_Mode::serial ? 1 : result.nb_threads);	// @Warning its threads only live during a walk
 
-		for (const fs::path& source_folder : project.sources_folders)
-		{
-			fs::path	absolute_source_folder = source_folder;
+		// Absolute search paths are computed once for all includes
+		for (const std::string_view& directory : project.sources_folders) {
+			result.sources_folders.push_back(fs::path(directory).is_relative() ? configuration.base_path / directory : fs::path(directory));
+		}
+		for (const std::string_view& directory : project.include_directories) {
+			result.include_directories.push_back(fs::path(directory).is_relative() ? configuration.base_path / directory : fs::path(directory));
+		}
 
-			if (source_folder.is_relative()) {
-				absolute_source_folder = configuration.base_path / absolute_source_folder;
-			}
+		// Scans of the previous run, files that didn't change since aren't read again
+		scan_cache_filepath = output_folder / (std::string(project.name) + ".scan_cache");
+		if (result.use_scan_cache_file && result.scan_cache_file.load(scan_cache_filepath)) {
+			nb_loaded_scans = result.scan_cache_file.size();
+		}
 
+		for (const fs::path& absolute_source_folder : result.sources_folders)
+		{
 			if (fs::is_directory(absolute_source_folder) == false) {
-				std::cout << "Error: unable to find the source directory " << absolute_source_folder << std::endl;
+				output << "Error: unable to find the source directory " << absolute_source_folder << std::endl;
 				return;
 			}
+		}
+
+		// Sources of all folders are listed first (while other projects are scanned), they are all scanned at once by the
+		// parallel scan, the pipeline lists them while files are scanned
+		std::vector<std::vector<std::string>>	listed_source_paths(result.scan_mode == Scan_Mode::pipeline ? 0 : result.sources_folders.size());
+
+		for (size_t source_folder_index = 0; source_folder_index < listed_source_paths.size(); source_folder_index++) {
+			list_sources(result, result.sources_folders[source_folder_index], listed_source_paths[source_folder_index]);
+		}
+
+		// @Warning the scan cache is shared, graphs are built one at a time (using all threads), files are written and images
+		// are generated concurrently
+		auto scan_cache_wait_start = std::chrono::high_resolution_clock::now();
+		scan_cache_lock.lock();
+		result.scan_cache_wait_duration = std::chrono::high_resolution_clock::now() - scan_cache_wait_start;
+
+		// Threads of the prefetcher are started once the project can use them, not while it waits for the scan cache
+		if (result.scan_mode == Scan_Mode::serial) {
+			result.prefetcher = std::make_unique<File_Prefetcher>();
+		}
 
-			for (const auto& entry : fs::recursive_directory_iterator(absolute_source_folder))
+		// Index entries of all directories where includes are searched (the parent directory is in a source folder), only
+		// directories that no other project indexed are enumerated
+		{
+			std::vector<fs::path>	indexed_directories = result.sources_folders;
+			double					build_duration = result.scan_cache->directory_index.stats().build_duration;
+
+			indexed_directories.insert(indexed_directories.end(), result.include_directories.begin(), result.include_directories.end());
+			result.scan_cache->directory_index.add_roots(indexed_directories, is_walked_directory);
+			index_build_duration = result.scan_cache->directory_index.stats().build_duration - build_duration;
+		}
+
+		std::vector<std::vector<Path_Id>>	source_paths(result.sources_folders.size());
+
+		if (result.scan_mode == Scan_Mode::pipeline) {
+			scan_with_pipeline(result, source_paths);	// Sources are listed by the walker while files are scanned
+		}
+		else
+		{
+			for (size_t source_folder_index = 0; source_folder_index < listed_source_paths.size(); source_folder_index++)
 			{
-				if (entry.is_regular_file() == false)
-					continue;
+				for (const std::string& source_path : listed_source_paths[source_folder_index]) {
+					source_paths[source_folder_index].push_back(result.scan_cache->paths.intern(source_path));
+				}
+			}
 
-				if (get_file_type(entry.path()) != File_Type::source)	// Headers are children of sources files
-					continue;
+			if (result.scan_mode == Scan_Mode::tasks) {
+				scan_in_parallel(result, source_paths);
+			}
+		}
 
-				// @TODO create nodes of header files directly here and add them to the result.nodes map but not to the result.root_nodes
-				// by doing it, it will reveal orphan header files in the graph (no source parent)
+		for (uint32_t source_folder_index = 0; source_folder_index < (uint32_t)result.sources_folders.size(); source_folder_index++)
+		{
+			const fs::path&				absolute_source_folder = result.sources_folders[source_folder_index];
+			const std::vector<Path_Id>&	folder_source_paths = source_paths[source_folder_index];
 
-				File_Node * node = new File_Node;
+			for (size_t source_index = 0; source_index < folder_source_paths.size(); source_index++)
+			{
+				fs::path	source_path = result.scan_cache->paths.path(folder_source_paths[source_index]);
 
-				node->unique_name = get_unique_name(result);
-				node->label = (absolute_source_folder.filename() / entry.path().lexically_relative(absolute_source_folder)).generic_string();	// @Warning we put the base of source directory to avoid conflicts if there is many similar source trees with a different root
-				node->path = entry.path();
-				node->file_type = File_Type::source;
-				node->file_found = true;
+				if (result.scan_mode == Scan_Mode::serial && source_index + 1 < folder_source_paths.size()
+					&& result.scan_cache->scans[get_file_scan(result, folder_source_paths[source_index + 1])].scanned == false) {
+					result.prefetcher->prefetch(result.scan_cache->paths.path(folder_source_paths[source_index + 1]));	// Read while the includes tree of this one is generated
+				}
 
-				result.nodes.insert(std::pair<std::string, File_Node*>(node->label, node));
+				// @TODO create nodes of header files directly here and add them to the result.nodes map but not to the result.root_nodes
+				// by doing it, it will reveal orphan header files in the graph (no source parent)
 
-				generate_includes_graph(configuration, project, absolute_source_folder, node, result);
+				Path_Id		label = result.scan_cache->paths.intern((absolute_source_folder.filename() / source_path.lexically_relative(absolute_source_folder)).generic_string());	// @Warning we put the base of source directory to avoid conflicts if there is many similar source trees with a different root
+				Node_Id		node = create_node(result, label, folder_source_paths[source_index], File_Type::source, true);
+
+				generate_includes_graph(absolute_source_folder, source_folder_index, node, result);
 
 				result.root_nodes.push_back(node);
 			}
@@ -318,13 +1400,53 @@ static void	generate_includes_graph(const incg::Configuration& configuration, co
 		// @TODO we also need to retrieve headers that are root nodes, stored in result.nodes
 		// I think that we can simply iterate over nodes in a non recursive way
 
+		result.graph.freeze();
+
+		if (result.use_scan_cache_file) {
+			scan_cache_file_up_to_date = collect_saved_scans(result, saved_scans, saved_includes);
+		}
+		if (result.watched_directories) {
+			list_watched_directories(result);
+		}
+		if (result.changed_files) {
+			impact_report << std::fixed << std::setprecision(3);	// Like the rest of the report
+			print_impact(result, impact_report);
+		}
+
+		node_texts.resize(result.graph.nb_nodes());
+		for (Node_Id node = 0; node < (Node_Id)result.graph.nb_nodes(); node++) {
+			node_texts[node] = {result.scan_cache->paths.path(result.graph.paths(node).label), result.scan_cache->paths.path(result.graph.paths(node).path)};
+		}
+		nb_physical_files = result.scan_cache->scans.size();
+		nb_paths = result.scan_cache->paths.size();
+		paths_memory_usage = result.scan_cache->paths.memory_usage();
+		include_spellings_memory_usage = result.scan_cache->include_spellings.memory_usage();
+		index_stats = result.scan_cache->directory_index.stats();
+		scan_cache_lock.unlock();
+
+		if (result.use_scan_cache_file)
+		{
+			result.scan_cache_file.close();	// @Warning before it is replaced
+			if (scan_cache_file_up_to_date == false) {
+				scan_cache_file_saved = Scan_Cache_File::save(scan_cache_filepath, saved_scans);
+			}
+		}
+
+		// Later analyses load the graph from the snapshot instead of scanning sources again
+		auto snapshot_start = std::chrono::high_resolution_clock::now();
+		snapshot_filepath = output_folder / (std::string(project.name) + ".graph");
+		snapshot_saved = Graph_Snapshot::save(snapshot_filepath, result.graph, node_texts, result.root_nodes);
+		snapshot_duration = std::chrono::high_resolution_clock::now() - snapshot_start;
+
 		// Generate the dot file
 		{
+			std::vector<bool>	printed(result.graph.nb_nodes(), false);
+
 			dot_file << "digraph {" << std::endl;
 			dot_file << "\t" "rankdir = LR" << std::endl;
 
 			for (size_t root_index = 0; root_index < result.root_nodes.size(); root_index++) {
-				print_node(dot_file, result.root_nodes[root_index]);
+				print_node(dot_file, node_texts, result.graph, printed, result.root_nodes[root_index]);
 			}
 
 			dot_file << "}" << std::endl;
@@ -332,7 +1454,7 @@ static void	generate_includes_graph(const incg::Configuration& configuration, co
 		}
 	}
 	auto generating_dot_end = std::chrono::high_resolution_clock::now();
-	std::chrono::duration<double> generating_dot_duration = generating_dot_end - generating_dot_start;
+	std::chrono::duration<double> generating_dot_duration = generating_dot_end - generating_dot_start - result.scan_cache_wait_duration;
 
 	// Print some stats
 	{
@@ -342,36 +1464,94 @@ static void	generate_includes_graph(const incg::Configuration& configuration, co
 		size_t	nb_header_lines = 0;
 		size_t	nb_header_not_found = 0;
 
-		for (const auto& pair : result.nodes) {
-			const File_Node* node = pair.second;
+		for (Node_Id node : result.nodes) {
+			if (node == invalid_node_id) {
+				continue;
+			}
 
-			if (node->file_type == File_Type::source) {
+			const Node_Attributes&	attributes = result.graph.attributes(node);
+
+			if (attributes.file_type == File_Type::source) {
 				nb_source_files++;
 			}
 			else {
 				nb_header_files++;
 			}
 
-			if (node->file_type == File_Type::source) {
-				nb_source_lines += node->nb_lines;
+			if (attributes.file_type == File_Type::source) {
+				nb_source_lines += attributes.nb_lines;
 			}
 			else {
-				nb_header_lines += node->nb_lines;
+				nb_header_lines += attributes.nb_lines;
 			}
 
-			if (node->file_found == false) {
+			if (attributes.file_found == false) {
 				nb_header_not_found++;
 			}
 		}
 
-		std::cout << std::fixed << std::setprecision(3);
+		output << std::fixed << std::setprecision(3);
 
-		std::cout << "\t" "Source files: " << nb_source_files << " - Lines of code: " << nb_source_lines << " - Average lines of code per file: " << (double)nb_source_lines / (double)nb_source_files << std::endl;
-		std::cout << "\t" "Header files: " << nb_header_files << " - Not found: " << nb_header_not_found << " - Lines of code: " << nb_header_lines << " - Average lines of code per file: " << (double)nb_header_lines / (double)nb_header_files << std::endl;
-		std::cout << "\t" "Total lines of code: " << nb_source_lines + nb_header_lines << " - Number of lines ratio (header / source): " << (double)nb_header_lines / (double)nb_source_lines << std::endl;
-		std::cout << std::endl;
+		output << "\t" "Source files: " << nb_source_files << " - Lines of code: " << nb_source_lines << " - Average lines of code per file: " << (double)nb_source_lines / (double)nb_source_files << std::endl;
+		output << "\t" "Header files: " << nb_header_files << " - Not found: " << nb_header_not_found << " - Lines of code: " << nb_header_lines << " - Average lines of code per file: " << (double)nb_header_lines / (double)nb_header_files << std::endl;
+		output << "\t" "Total lines of code: " << nb_source_lines + nb_header_lines << " - Number of lines ratio (header / source): " << (double)nb_header_lines / (double)nb_source_lines << std::endl;
+		output << std::endl;
 
-		std::cout << "\t" "Dot file generated in: " << generating_dot_duration.count() << "s" << std::endl;
+		if (result.prefetcher)
+		{
+			output << "\t" "Files prefetched: " << result.prefetcher->stats().nb_prefetched << " (" << prefetch_backend_names[(size_t)result.prefetcher->backend()] << ")"
+				<< " - Opened from prefetch: " << result.prefetcher->stats().nb_hits << " - Read synchronously: " << result.prefetcher->stats().nb_misses << std::endl;
+			result.prefetcher.reset();	// Stop threads (or the ring)
+		}
+		const Directory_Walker::Stats&	walker_stats = result.source_walker.stats();
+
+		output << "\t" "Source folders walked: " << walker_stats.nb_entries << " entries in " << walker_stats.nb_directories << " directories in " << walker_stats.duration << "s ("
+			<< result.source_walker.nb_threads() << (result.source_walker.nb_threads() > 1 ? " threads" : " thread") << ", "
+			<< (walker_stats.duration > 0.0 ? (double)walker_stats.nb_entries / walker_stats.duration : 0.0) << " entries/s) - Pruned directories: " << walker_stats.nb_pruned_directories
+			<< " - Unreadable directories: " << walker_stats.nb_unreadable_directories << std::endl;
+		output << "\t" "Directory index (shared by projects): " << index_stats.nb_entries << " entries in " << index_stats.nb_roots << " roots - Enumerated directories: " << index_stats.nb_directories
+			<< " - Pruned: " << index_stats.nb_pruned_directories << " - Built for this project in " << index_build_duration << "s" << std::endl;
+		output << "\t" "Include resolution: " << result.include_resolution_duration.count() << "s - Lookups in the index: " << result.index_lookups.nb_index_lookups << " (stat calls saved)"
+			<< " - On the file system: " << result.index_lookups.nb_fallbacks << std::endl;
+		output << "\t" "Resolution cache: " << result.nb_resolution_hits << " hits - " << result.nb_resolution_misses << " misses - Hit rate: "
+			<< 100.0 * (double)result.nb_resolution_hits / (double)std::max<size_t>(result.nb_resolution_hits + result.nb_resolution_misses, 1) << "%" << std::endl;
+		output << "\t" "Files scanned: " << result.nb_scans << " (" << scan_mode_names[(size_t)result.scan_mode];
+		if (result.scan_mode != Scan_Mode::serial) {
+			output << ", " << result.nb_threads << (result.nb_threads > 1 ? " threads" : " thread");
+		}
+		output << ")" << " - Scans reused (other paths or other projects): " << result.nb_reused_scans
+			<< " - Physical files of all projects: " << nb_physical_files << std::endl;
+		if (result.use_scan_cache_file)
+		{
+			output << "\t" "Scan cache file: " << nb_loaded_scans << " entries loaded - Files not read (unchanged): " << result.nb_cached_scans
+				<< " - " << (scan_cache_file_saved ? "Saved: " : "Up to date: ") << saved_scans.size() << " entries" << std::endl;
+		}
+		for (const Stage_Report& stage : result.pipeline_stages)
+		{
+			output << "\t" "Pipeline stage " << stage.name << " (" << stage.nb_threads << (stage.nb_threads > 1 ? " threads" : " thread") << "): " << stage.nb_items << " files"
+				<< " - Busy: " << stage.busy_duration << "s (" << (stage.busy_duration > 0.0 ? (double)stage.nb_items * (double)stage.nb_threads / stage.busy_duration : 0.0) << " files/s)"
+				<< " - Blocked by the next stage: " << stage.blocked_duration << "s - Idle: " << stage.idle_duration << "s";
+			if (stage.queue_capacity) {
+				output << " - Input queue: " << stage.average_queue_size << " average, " << stage.max_queue_size << " max, " << stage.queue_capacity << " capacity";
+			}
+			if (stage.max_backlog_size) {
+				output << " - Backlog: " << stage.max_backlog_size << " max";
+			}
+			output << std::endl;
+		}
+		output << "\t" "Graph: " << result.graph.nb_nodes() << " nodes - " << result.graph.nb_edges() << " edges - " << (double)result.graph.memory_usage() / (1024.0 * 1024.0) << " MB" << std::endl;
+		if (snapshot_saved) {
+			output << "\t" "Graph snapshot: " << snapshot_filepath.generic_string() << " written in " << snapshot_duration.count() << "s" << std::endl;
+		}
+		else {
+			output << "\t" "Error: unable to write the graph snapshot " << snapshot_filepath.generic_string() << std::endl;
+		}
+		output << impact_report.str();
+		output << "\t" "Project arena: " << result.arena.stats().nb_allocations << " allocations - Used: " << (double)result.arena.stats().used_bytes / (1024.0 * 1024.0) << " MB"
+			<< " - High-water mark: " << (double)result.arena.stats().high_water_mark / (1024.0 * 1024.0) << " MB in " << result.arena.stats().nb_blocks << " blocks" << std::endl;
+		output << "\t" "Paths: " << nb_paths << " (" << (double)paths_memory_usage / (1024.0 * 1024.0) << " MB)"
+			<< " - Include spellings: " << (double)include_spellings_memory_usage / (1024.0 * 1024.0) << " MB - Peak memory of the process: " << (double)peak_memory_usage() / (1024.0 * 1024.0) << " MB" << std::endl;
+		output << "\t" "Dot file generated in: " << generating_dot_duration.count() << "s" << std::endl;
 	}
 
 	// Generate the graph image
@@ -383,38 +1563,229 @@ static void	generate_includes_graph(const incg::Configuration& configuration, co
 		command_line = "dot.exe " + dot_filepath + " -Tpng -o " + png_filepath;
 		command_line_result = system(command_line.c_str());
 		if (command_line_result != 0) {
-			std::cerr << "Command line : \"" << command_line << "\" failed." << std::endl
+			output << "Command line : \"" << command_line << "\" failed." << std::endl
 				<< "Do you have installed Graphiz tools and put the bin folder into the PATH environment variable? [You can download it at: https://www.graphviz.org/]." << std::endl;
 		}
 	}
 	auto generating_image_end = std::chrono::high_resolution_clock::now();
 	std::chrono::duration<double> generating_image_duration = generating_image_end - generating_image_start;
 
-	std::cout << "\t" "Image generated in: " << generating_image_duration.count() << "s" << std::endl;
-	std::cout << std::endl;
+	output << "\t" "Image generated in: " << generating_image_duration.count() << "s" << std::endl;
+	output << std::endl;
 }
 
-void generate_includes_graph(const incg::Configuration& configuration)
+/// Generate the given projects (indices in the configuration), reports are printed in the order of the configuration,
+/// followed by a summary of durations
+/// Directories watched by each project are listed in watched_directories if it isn't null (by project of the configuration)
+static void generate_projects(const incg::Configuration& configuration, const Generation_Options& options, Scan_Cache& scan_cache, const std::vector<size_t>& project_indices,
+							  std::vector<std::vector<Path_Id>>* watched_directories)
 {
-	std::vector<Project_Result>	results;
+	auto start = std::chrono::high_resolution_clock::now();
+
+	size_t						nb_projects = project_indices.size();
+	size_t						nb_hardware_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	size_t						nb_threads = options.nb_threads == 0 ? nb_hardware_threads : options.nb_threads;
+	Scan_Mode					scan_mode = options.scan_mode;
+	size_t						nb_concurrent_projects = std::min(options.nb_concurrent_projects == 0 ? nb_hardware_threads : options.nb_concurrent_projects, nb_projects);
+
+	// Results of projects are released at the end of each project, only timings are kept for the summary
+	std::vector<std::chrono::duration<double>>	durations(nb_projects);
+	std::vector<std::chrono::duration<double>>	scan_cache_wait_durations(nb_projects);
+
+	// Reports are for humans, in the impact query the standard output is only the list of sources (for scripts)
+	std::ostream&					report = options.query_impact ? std::cerr : std::cout;
+
+	// Projects are taken in order by threads, reports are buffered to be printed in the order of the configuration
+	std::vector<std::ostringstream>	outputs(nb_projects);
+	std::vector<std::ostringstream>	impact_outputs(options.query_impact ? nb_projects : 0);
+	std::vector<char>				done(nb_projects, false);
+	std::mutex						done_mutex;
+	std::condition_variable			project_done;
+	std::atomic<size_t>				next_project{0};
+	std::vector<std::thread>		threads;
+
+	for (size_t thread_index = 0; thread_index < nb_concurrent_projects; thread_index++)
+	{
+		threads.emplace_back([&]() {
+			for (size_t index = next_project++; index < nb_projects; index = next_project++)
+			{
+				size_t			project_index = project_indices[index];
+				Project_Result	result;
+				auto			project_start = std::chrono::high_resolution_clock::now();
+				fs::path		output_folder = configuration.projects[project_index].output_folder;
+
+				result.scan_cache = &scan_cache;
+				result.scan_mode = scan_mode;
+				result.nb_threads = nb_threads;
+				result.use_scan_cache_file = options.use_scan_cache_file;
+				result.watched_directories = watched_directories ? &(*watched_directories)[project_index] : nullptr;
+				result.changed_files = options.query_impact ? &options.changed_files : nullptr;
+				result.impact_output = options.query_impact ? &impact_outputs[index] : nullptr;
+
+				if (output_folder.is_relative()) {
+					output_folder = configuration.base_path / output_folder;
+				}
+
+				fs::create_directories(output_folder);
+				if (fs::is_directory(output_folder) == false) {
+					outputs[index] << "Error: unable to find or create the directory " << output_folder << std::endl;
+				}
+				else
+				{
+					// On request the snapshot of the last run answers the impact query, sources aren't scanned (unless graphs are watched)
+					bool	answered = options.query_impact && options.impact_from_snapshot && watched_directories == nullptr
+						&& print_impact_from_snapshot(configuration.projects[project_index], output_folder, options.changed_files, outputs[index], impact_outputs[index]);
+
+					if (answered == false) {
+						generate_includes_graph(configuration, configuration.projects[project_index], output_folder, result, outputs[index]);	// Or no snapshot yet (or of another version)
+					}
+				}
+				result.duration = std::chrono::high_resolution_clock::now() - project_start;
+				durations[index] = result.duration;
+				scan_cache_wait_durations[index] = result.scan_cache_wait_duration;
+
+				{
+					std::lock_guard<std::mutex>	lock(done_mutex);
+
+					done[index] = true;
+				}
+				project_done.notify_all();
+			}
+		});
+	}
 
-	results.resize(configuration.projects.size());
+	for (size_t index = 0; index < nb_projects; index++)
+	{
+		std::unique_lock<std::mutex>	lock(done_mutex);
 
-	// @TODO launch that in threads (check outputs to std::cout first)
-	for (size_t project_index = 0; project_index < configuration.projects.size(); project_index++)
+		project_done.wait(lock, [&]() { return done[index] != false; });
+		report << outputs[index].str() << std::flush;
+		if (options.query_impact) {
+			std::cout << impact_outputs[index].str() << std::flush;
+		}
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	std::chrono::duration<double>	duration = std::chrono::high_resolution_clock::now() - start;
+
+	report << std::fixed << std::setprecision(3);
+	report << "Summary: " << nb_projects << " projects in " << duration.count() << "s (" << nb_concurrent_projects << " at a time - Scan: " << scan_mode_names[(size_t)scan_mode] << ", " << nb_threads << (nb_threads > 1 ? " threads" : " thread") << ")" << std::endl;
+	for (size_t index = 0; index < nb_projects; index++) {
+		report << "\t" << configuration.projects[project_indices[index]].name << ": " << durations[index].count() << "s"
+			<< " - Waiting for other projects: " << scan_cache_wait_durations[index].count() << "s" << std::endl;
+	}
+}
+
+/// The file will be scanned again, its scan is forgotten by all its paths
+/// @Warning the old scan stays in the cache (unused), the cache grows a bit at each change
+static void forget_scan(Scan_Cache& cache, Path_Id path)
+{
+	if (path == invalid_path_id || path >= cache.path_scans.size() || cache.path_scans[path] == no_scan) {
+		return;
+	}
+
+	uint32_t	scan_index = cache.path_scans[path];
+	auto		it = cache.scan_by_identity.find(cache.scans[scan_index].identity);
+
+	if (it != cache.scan_by_identity.end() && it->second == scan_index) {
+		cache.scan_by_identity.erase(it);	// Saving a file can replace it by a new one (another identity), or keep it
+	}
+	for (uint32_t& path_scan : cache.path_scans)
 	{
-		fs::path	output_folder = configuration.projects[project_index].output_folder;
+		if (path_scan == scan_index) {
+			path_scan = no_scan;
+		}
+	}
+}
+
+/// Generate projects affected by changes of files until the process is stopped
+/// Only changed files are scanned again, scans of other files are kept in memory (and in scan cache files), graphs of
+/// affected projects are built again from them
+static void watch_projects(const incg::Configuration& configuration, const Generation_Options& options, Scan_Cache& scan_cache, std::vector<std::vector<Path_Id>>& watched_directories)
+{
+	static constexpr std::chrono::milliseconds	settle_delay{50};
 
-		if (output_folder.is_relative()) {
-			output_folder = configuration.base_path / output_folder;
+	size_t								nb_projects = configuration.projects.size();
+	File_Watcher						watcher;
+	std::vector<File_Watcher::Change>	changes;
+	std::vector<size_t>					project_indices;
+	std::vector<char>					affected(nb_projects);
+
+	for (;;)
+	{
+		size_t	nb_unwatched_directories = 0;
+
+		// Directories of files that appeared in graphs since the last update are added
+		for (const std::vector<Path_Id>& directories : watched_directories)
+		{
+			for (Path_Id directory : directories) {
+				nb_unwatched_directories += watcher.watch(scan_cache.paths.path(directory)) ? 0 : 1;
+			}
+		}
+		std::cout << "Watching " << watcher.nb_watched_directories() << " directories";
+		if (nb_unwatched_directories) {
+			std::cout << " (" << nb_unwatched_directories << " can't be watched)";
 		}
+		std::cout << ", waiting for changes..." << std::endl;
 
-		fs::create_directories(output_folder);
-		if (fs::is_directory(output_folder) == false) {
-			std::cout << "Error: unable to find or create the directory " << output_folder << std::endl;
-			return;
+		changes.clear();
+		bool	is_complete = watcher.wait_changes(changes, settle_delay);
+
+		std::fill(affected.begin(), affected.end(), false);
+		if (is_complete == false)
+		{
+			// Some changes are lost, every file is scanned again (unchanged ones are loaded from scan cache files)
+			scan_cache.scans.clear();
+			scan_cache.path_scans.clear();
+			scan_cache.scan_by_identity.clear();
+			scan_cache.scanned_includes.clear();
+			scan_cache.directory_index.clear();
+			std::fill(affected.begin(), affected.end(), true);
+		}
+		for (const File_Watcher::Change& change : changes)
+		{
+			Path_Id	directory = scan_cache.paths.find(change.directory);
+
+			forget_scan(scan_cache, scan_cache.paths.find(change.directory + "/" + change.name));
+			scan_cache.directory_index.forget_root(change.directory);	// Enumerated again by the next project that needs it
+			for (size_t project_index = 0; project_index < nb_projects; project_index++)
+			{
+				if (std::binary_search(watched_directories[project_index].begin(), watched_directories[project_index].end(), directory)) {
+					affected[project_index] = true;
+				}
+			}
 		}
 
-		generate_includes_graph(configuration, configuration.projects[project_index], output_folder, results[project_index]);
+		project_indices.clear();
+		for (size_t project_index = 0; project_index < nb_projects; project_index++)
+		{
+			if (affected[project_index]) {
+				project_indices.push_back(project_index);
+			}
+		}
+		if (project_indices.empty()) {
+			continue;
+		}
+
+		std::cout << "Changes: " << changes.size() << " entries - Projects to update: " << project_indices.size() << std::endl << std::endl;
+		generate_projects(configuration, options, scan_cache, project_indices, &watched_directories);
+	}
+}
+
+void generate_includes_graph(const incg::Configuration& configuration, const Generation_Options& options)
+{
+	Scan_Cache							scan_cache;
+	std::vector<size_t>					project_indices(configuration.projects.size());
+	std::vector<std::vector<Path_Id>>	watched_directories(options.watch ? configuration.projects.size() : 0);
+
+	for (size_t project_index = 0; project_index < project_indices.size(); project_index++) {
+		project_indices[project_index] = project_index;
+	}
+
+	generate_projects(configuration, options, scan_cache, project_indices, options.watch ? &watched_directories : nullptr);
+	if (options.watch) {
+		watch_projects(configuration, options, scan_cache, watched_directories);
 	}
 }
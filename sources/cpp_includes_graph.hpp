@@ -6,8 +6,30 @@
 #include <string>
 #include <vector>
 
+enum class Scan_Mode
+{
+	serial,		/// Files are read (with a background prefetcher) and parsed while the graph is generated
+	tasks,		/// Files are scanned by tasks on a work stealing pool, then the graph is generated
+	pipeline	/// Files are scanned by a pipeline of stages (walker, readers, lexers, resolver), then the graph is generated
+};
+
+struct Generation_Options
+{
+	Scan_Mode					scan_mode = Scan_Mode::pipeline;
+	size_t						nb_threads = 0;					/// Threads of the pool or of each parallel stage of the pipeline, 0 for the number of hardware threads
+	size_t						nb_concurrent_projects = 0;		/// Projects generated at the same time, 0 for the number of hardware threads
+	bool						use_scan_cache_file = true;		/// Scans of unchanged files are loaded from the previous run (a file in the output folder)
+	bool						watch = false;					/// Once generated, projects are generated again when their files change, until the process is stopped
+	bool						query_impact = false;			/// Sources that include one of changed_files (directly or not) are listed on the standard output, reports go to the error output
+	bool						impact_from_snapshot = false;	/// The impact query is answered from the graph snapshot of the last run when it is valid, sources aren't scanned (includes changed since aren't known)
+	std::vector<std::string>	changed_files;					/// Relative to the current directory, or absolute
+};
+
 /*
 	This function print on the standard output and generate an image that represent the graph of the includes.
 	It use dot binary from the Graphiz framework to generate the image.
+	The graph is the same whatever the number of threads. Reports of projects are printed in the order of the configuration,
+	followed by a summary of durations.
+	In watch mode it doesn't return.
 */
-void	generate_includes_graph(const incg::Configuration& configuration);
+void	generate_includes_graph(const incg::Configuration& configuration, const Generation_Options& options = Generation_Options());
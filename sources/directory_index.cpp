@@ -0,0 +1,242 @@
+#include "directory_index.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+/// Return the key of a path that is already normalized
+static std::string normal_path_key(const fs::path& path)
+{
+	std::string	key = path.generic_string();
+
+#if defined(_WIN32)
+	std::transform(key.begin(), key.end(), key.begin(), ::tolower);	// @Warning paths are case insensitive on Windows
+#endif
+	if (key.length() > 1 && key.back() == '/') {
+		key.pop_back();
+	}
+	return key;
+}
+
+std::string Directory_Index::key(const fs::path& path)
+{
+	return normal_path_key(path.lexically_normal());
+}
+
+/// Return true if the path is the root or is under it (keys of both)
+static bool is_in_root(const std::string& path_key, const std::string& root)
+{
+	return path_key.compare(0, root.length(), root) == 0
+		&& (path_key.length() == root.length() || root.back() == '/' || path_key[root.length()] == '/');
+}
+
+/// Return false if the enumeration failed (the root isn't indexed)
+static bool enumerate_root(const fs::path& root, const Directory_Index::Name_Filter& directory_filter, std::vector<std::string>& entries, std::vector<std::string>& unenumerated_directories,
+						   size_t& nb_directories, size_t& nb_pruned_directories)
+{
+	std::error_code	error;
+
+	nb_directories = 1;
+	nb_pruned_directories = 0;
+	for (fs::recursive_directory_iterator it(root, error), end; !error && it != end; it.increment(error))
+	{
+		const fs::directory_entry&	entry = *it;
+
+		if (entry.is_symlink(error))
+		{
+			fs::file_status	target_status = fs::status(entry.path(), error);	// @Warning not an error if the target doesn't exist
+
+			if (fs::exists(target_status)) {
+				entries.push_back(normal_path_key(entry.path()));
+			}
+			if (fs::is_directory(target_status)) {
+				unenumerated_directories.push_back(entries.back());	// Not followed by the iterator
+			}
+			error.clear();
+			continue;
+		}
+
+		entries.push_back(normal_path_key(entry.path()));
+		if (entry.is_directory(error))
+		{
+			if (directory_filter && directory_filter(entry.path().filename().string()) == false)
+			{
+				it.disable_recursion_pending();
+				unenumerated_directories.push_back(entries.back());
+				nb_pruned_directories++;
+			}
+			else {
+				nb_directories++;
+			}
+		}
+	}
+	return !error;
+}
+
+void Directory_Index::add_roots(const std::vector<fs::path>& roots, const Name_Filter& directory_filter)
+{
+	auto	start = std::chrono::high_resolution_clock::now();
+
+	// Roots that are in an indexed root or in another new root are enumerated with it
+	std::vector<std::string>	new_roots;
+	std::vector<fs::path>		enumerated_roots;
+
+	for (const fs::path& root : roots)
+	{
+		fs::path	normal_root = root.lexically_normal();
+		std::string	root_key = normal_path_key(normal_root);
+		bool		is_nested = false;
+
+		if (fs::is_directory(normal_root) == false) {
+			continue;
+		}
+		for (const std::vector<std::string>* other_roots : {&m_roots, &new_roots})
+		{
+			for (const std::string& other_root : *other_roots) {
+				is_nested = is_nested || is_in_root(root_key, other_root);
+			}
+		}
+		if (is_nested) {
+			continue;
+		}
+
+		// @Warning a root that contains previous ones replaces them (entries of indexed ones are enumerated again)
+		for (size_t i = 0; i < new_roots.size(); )
+		{
+			if (is_in_root(new_roots[i], root_key))
+			{
+				new_roots.erase(new_roots.begin() + i);
+				enumerated_roots.erase(enumerated_roots.begin() + i);
+			}
+			else {
+				i++;
+			}
+		}
+		m_roots.erase(std::remove_if(m_roots.begin(), m_roots.end(), [&root_key](const std::string& indexed_root) { return is_in_root(indexed_root, root_key); }), m_roots.end());
+		new_roots.push_back(root_key);
+		enumerated_roots.push_back(normal_root);
+	}
+
+	if (new_roots.empty()) {
+		return;
+	}
+
+	// A thread per new root
+	std::vector<std::vector<std::string>>	entries(new_roots.size());
+	std::vector<std::vector<std::string>>	unenumerated_directories(new_roots.size());
+	std::vector<size_t>						nb_directories(new_roots.size(), 0);
+	std::vector<size_t>						nb_pruned_directories(new_roots.size(), 0);
+	std::vector<char>						enumerated(new_roots.size(), false);
+	std::vector<std::thread>				threads;
+
+	for (size_t i = 0; i < new_roots.size(); i++) {
+		threads.emplace_back([&, i]() {
+			enumerated[i] = enumerate_root(enumerated_roots[i], directory_filter, entries[i], unenumerated_directories[i], nb_directories[i], nb_pruned_directories[i]);
+		});
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	for (size_t i = 0; i < new_roots.size(); i++)
+	{
+		if (enumerated[i] == false) {
+			continue;	// Paths in this root are checked on the file system
+		}
+
+		m_entries.insert(new_roots[i]);
+		m_entries.insert(std::make_move_iterator(entries[i].begin()), std::make_move_iterator(entries[i].end()));
+		m_unenumerated_directories.insert(std::make_move_iterator(unenumerated_directories[i].begin()), std::make_move_iterator(unenumerated_directories[i].end()));
+		m_stats.nb_directories += nb_directories[i];
+		m_stats.nb_pruned_directories += nb_pruned_directories[i];
+		m_roots.push_back(new_roots[i]);
+	}
+	std::sort(m_roots.begin(), m_roots.end(), [](const std::string& a, const std::string& b) { return a.length() > b.length(); });
+
+	m_stats.nb_roots = m_roots.size();
+	m_stats.nb_entries = m_entries.size();
+	m_stats.nb_builds++;
+	m_stats.build_duration += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void Directory_Index::forget_root(const fs::path& path)
+{
+	const std::string*	found_root = find_root(key(path));
+
+	if (found_root == nullptr) {
+		return;
+	}
+
+	std::string	root = *found_root;
+
+	for (std::unordered_set<std::string>* entries : {&m_entries, &m_unenumerated_directories})
+	{
+		for (auto it = entries->begin(); it != entries->end(); )
+		{
+			if (is_in_root(*it, root)) {
+				it = entries->erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+	}
+	m_roots.erase(std::find(m_roots.begin(), m_roots.end(), root));
+
+	m_stats.nb_roots = m_roots.size();
+	m_stats.nb_entries = m_entries.size();
+}
+
+void Directory_Index::clear()
+{
+	m_roots.clear();
+	m_entries.clear();
+	m_unenumerated_directories.clear();
+
+	m_stats.nb_roots = 0;
+	m_stats.nb_entries = 0;
+}
+
+const std::string* Directory_Index::find_root(const std::string& path_key) const
+{
+	for (const std::string& root : m_roots)
+	{
+		if (is_in_root(path_key, root)) {
+			return &root;
+		}
+	}
+	return nullptr;
+}
+
+bool Directory_Index::goes_through_unenumerated_directory(const std::string& path_key, size_t root_length) const
+{
+	if (m_unenumerated_directories.empty()) {
+		return false;
+	}
+
+	for (size_t position = path_key.find('/', root_length + 1); position != std::string::npos; position = path_key.find('/', position + 1))
+	{
+		if (m_unenumerated_directories.find(path_key.substr(0, position)) != m_unenumerated_directories.end()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool Directory_Index::exists(const fs::path& path, Lookup_Stats& lookup_stats) const
+{
+	std::string			path_key = key(path);
+	const std::string*	root = find_root(path_key);
+
+	if (root == nullptr
+		|| goes_through_unenumerated_directory(path_key, root->length()))
+	{
+		lookup_stats.nb_fallbacks++;
+		return fs::exists(path);
+	}
+
+	lookup_stats.nb_index_lookups++;
+	return m_entries.find(path_key) != m_entries.end();
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+/// Index of all entries (files and directories) of some root directories, each root is enumerated once (in parallel with
+/// the other new roots), so an index can be shared by projects with common include directories
+/// exists is then a hash lookup instead of a stat, paths outside of roots are checked on the file system
+/// @Warning entries created after the enumeration of their root aren't seen, until the root is forgotten
+/// @Warning paths are compared after a lexical normalization ("a/../b" is "b" even if "a" is a symbolic link),
+/// paths that go through a symbolic link to a directory or a pruned directory are checked on the file system
+class Directory_Index
+{
+public:
+	struct Stats
+	{
+		size_t	nb_roots = 0;
+		size_t	nb_entries = 0;
+		size_t	nb_directories = 0;			// Enumerated directories (one open and a few getdents each)
+		size_t	nb_pruned_directories = 0;	// Not enumerated, refused by the directory filter
+		size_t	nb_builds = 0;				// Enumerations of roots (new or forgotten)
+		double	build_duration = 0.0;		// In seconds, of all builds
+	};
+
+	/// Lookups are counted by the caller, an index is shared
+	struct Lookup_Stats
+	{
+		size_t	nb_index_lookups = 0;	// Answered without syscall
+		size_t	nb_fallbacks = 0;		// Answered by the file system
+	};
+
+	/// Called with the name of directories (not the path)
+	using Name_Filter = std::function<bool(std::string_view name)>;
+
+	/// Enumerate recursively roots that aren't indexed yet (nor in an indexed root), a thread per root
+	/// Directories refused by directory_filter aren't enumerated (a null filter accepts everything)
+	void			add_roots(const std::vector<std::filesystem::path>& roots, const Name_Filter& directory_filter);
+
+	/// Drop entries of the root that contains the path (a changed entry), the root is enumerated again by the next add_roots
+	void			forget_root(const std::filesystem::path& path);
+
+	/// Drop all roots
+	void			clear();
+
+	/// Same result as std::filesystem::exists
+	bool			exists(const std::filesystem::path& path, Lookup_Stats& lookup_stats) const;
+
+	const Stats&	stats() const { return m_stats; }
+
+private:
+	static std::string	key(const std::filesystem::path& path);
+
+	const std::string*	find_root(const std::string& path_key) const;
+	bool				goes_through_unenumerated_directory(const std::string& path_key, size_t root_length) const;
+
+	std::vector<std::string>		m_roots;					// Keys of roots, the longest first
+	std::unordered_set<std::string>	m_entries;					// Keys of all entries under roots
+	std::unordered_set<std::string>	m_unenumerated_directories;	// Symbolic links to directories and pruned directories
+	Stats							m_stats;
+};
@@ -0,0 +1,291 @@
+#include "directory_walker.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <stdint.h>
+
+#if defined(__linux__)
+#	include <dirent.h>		// DT_* constants
+#	include <fcntl.h>
+#	include <sys/stat.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+#	include <cstddef>		// offsetof
+#	include <cstring>
+#endif
+
+namespace fs = std::filesystem;
+
+enum class Entry_Kind : uint8_t
+{
+	other,
+	file,
+	directory
+};
+
+struct Walked_Directory;
+
+struct Walked_Entry
+{
+	std::string			name;
+	Walked_Directory*	directory = nullptr;	// Null for files
+};
+
+struct Walked_Directory
+{
+	std::string					path;		// Ends with a '/'
+	std::vector<Walked_Entry>	entries;	// Accepted files and entered directories, in the order of the file system
+};
+
+#if defined(__linux__)
+/// Record filled by getdents64, the name follows (null terminated)
+struct Linux_Dirent64
+{
+	uint64_t		d_ino;
+	int64_t			d_off;
+	unsigned short	d_reclen;
+	unsigned char	d_type;
+	char			d_name[1];
+};
+
+static Entry_Kind stat_entry_kind(int directory_fd, const char* name, int flags)
+{
+	struct stat	status;
+
+	if (fstatat(directory_fd, name, &status, flags) != 0) {
+		return Entry_Kind::other;	// A broken symbolic link or a removed entry
+	}
+	if (S_ISLNK(status.st_mode)) {
+		return stat_entry_kind(directory_fd, name, 0) == Entry_Kind::file ? Entry_Kind::file : Entry_Kind::other;	// Linked directories aren't followed
+	}
+	return S_ISREG(status.st_mode) ? Entry_Kind::file : S_ISDIR(status.st_mode) ? Entry_Kind::directory : Entry_Kind::other;
+}
+
+/// Call on_entry(name, kind) for each entry of the directory, return false if it can't be opened
+template<typename Function>
+static bool read_directory(const std::string& path, std::vector<char>& buffer, Function on_entry)
+{
+	int	directory_fd = openat(AT_FDCWD, path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+	if (directory_fd < 0) {
+		return false;
+	}
+
+	for (;;)
+	{
+		long	size = syscall(SYS_getdents64, directory_fd, buffer.data(), buffer.size());
+
+		if (size <= 0) {
+			break;	// End of the directory, or an error in the middle of it (entries already read are kept)
+		}
+		for (long position = 0; position < size; )
+		{
+			const Linux_Dirent64*	record = (const Linux_Dirent64*)(buffer.data() + position);
+			const char*				name = buffer.data() + position + offsetof(Linux_Dirent64, d_name);
+			Entry_Kind				kind = Entry_Kind::other;
+
+			position += record->d_reclen;
+			if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+				continue;
+			}
+
+			switch (record->d_type)
+			{
+			case DT_REG:		kind = Entry_Kind::file; break;
+			case DT_DIR:		kind = Entry_Kind::directory; break;
+			case DT_LNK:		kind = stat_entry_kind(directory_fd, name, 0) == Entry_Kind::file ? Entry_Kind::file : Entry_Kind::other; break;
+			case DT_UNKNOWN:	kind = stat_entry_kind(directory_fd, name, AT_SYMLINK_NOFOLLOW); break;	// Some file systems don't fill d_type
+			default:			break;
+			}
+			on_entry(std::string_view(name, strlen(name)), kind);
+		}
+	}
+	close(directory_fd);
+	return true;
+}
+#else
+// @TODO use FindFirstFileExW with FIND_FIRST_EX_LARGE_FETCH and FindExInfoBasic on Windows
+template<typename Function>
+static bool read_directory(const std::string& path, std::vector<char>& buffer, Function on_entry)
+{
+	std::error_code	error;
+
+	fs::directory_iterator	it(fs::path(path), error);
+	if (error) {
+		return false;
+	}
+	for (fs::directory_iterator end; !error && it != end; it.increment(error))
+	{
+		const fs::directory_entry&	entry = *it;
+		std::error_code				status_error;
+		std::string					name = entry.path().filename().string();
+		Entry_Kind					kind = Entry_Kind::other;
+
+		if (entry.is_symlink(status_error)) {
+			kind = entry.is_regular_file(status_error) ? Entry_Kind::file : Entry_Kind::other;	// Linked directories aren't followed
+		}
+		else if (entry.is_directory(status_error)) {
+			kind = Entry_Kind::directory;
+		}
+		else if (entry.is_regular_file(status_error)) {
+			kind = Entry_Kind::file;
+		}
+		on_entry(std::string_view(name), kind);
+	}
+	return true;
+}
+#endif
+
+Directory_Walker::Directory_Walker(size_t nb_threads)
+	: m_nb_threads(nb_threads == 0 ? std::max<size_t>(std::thread::hardware_concurrency(), 1) : nb_threads)
+{
+}
+
+bool Directory_Walker::walk(const fs::path& root, const Name_Filter& file_filter, const Name_Filter& directory_filter, std::vector<std::string>& files,
+							std::vector<std::string>* directories_paths)
+{
+	static constexpr size_t	getdents_buffer_size = 64 * 1024;
+
+	auto	start = std::chrono::high_resolution_clock::now();
+
+	std::deque<Walked_Directory>	directories;	// @Warning stable addresses, entries point to their directory
+	std::vector<Walked_Directory*>	work_queue;		// Directories to read, the last one first (depth first keeps the queue short)
+	size_t							nb_pending = 1;	// Queued or being read
+	bool							root_read = false;
+	Stats							stats;
+	std::mutex						mutex;
+	std::condition_variable			work_available;
+
+	directories.emplace_back();
+	directories.back().path = root.generic_string();
+	if (directories.back().path.empty() || directories.back().path.back() != '/') {
+		directories.back().path += '/';
+	}
+	work_queue.push_back(&directories.back());
+
+	auto worker = [&]() {
+		std::vector<char>		buffer(getdents_buffer_size);
+		std::vector<size_t>		subdirectories;	// Indices of entries that are directories to read
+		Stats					thread_stats;
+
+		for (;;)
+		{
+			Walked_Directory*	directory;
+			{
+				std::unique_lock<std::mutex>	lock(mutex);
+
+				work_available.wait(lock, [&]() { return work_queue.empty() == false || nb_pending == 0; });
+				if (work_queue.empty()) {
+					break;
+				}
+				directory = work_queue.back();
+				work_queue.pop_back();
+			}
+
+			// Entries are filtered here, in parallel, only what is kept is stored
+			subdirectories.clear();
+			bool	is_read = read_directory(directory->path, buffer, [&](std::string_view name, Entry_Kind kind) {
+				thread_stats.nb_entries++;
+				if (kind == Entry_Kind::file && (!file_filter || file_filter(name)))
+				{
+					directory->entries.push_back(Walked_Entry{std::string(name), nullptr});
+					thread_stats.nb_files++;
+				}
+				else if (kind == Entry_Kind::directory)
+				{
+					if (directory_filter && directory_filter(name) == false) {
+						thread_stats.nb_pruned_directories++;
+						return;
+					}
+					subdirectories.push_back(directory->entries.size());
+					directory->entries.push_back(Walked_Entry{std::string(name), nullptr});
+				}
+			});
+			thread_stats.nb_directories += is_read ? 1 : 0;
+			thread_stats.nb_unreadable_directories += is_read ? 0 : 1;
+
+			std::unique_lock<std::mutex>	lock(mutex);
+
+			if (directory == &directories.front()) {
+				root_read = is_read;
+			}
+			for (size_t entry_index : subdirectories)
+			{
+				Walked_Entry&	entry = directory->entries[entry_index];
+
+				directories.emplace_back();
+				directories.back().path = directory->path + entry.name + '/';
+				entry.directory = &directories.back();
+				work_queue.push_back(entry.directory);
+			}
+			nb_pending += subdirectories.size();
+			nb_pending--;
+			if (nb_pending == 0 || subdirectories.size() > 1) {
+				work_available.notify_all();
+			}
+			else if (subdirectories.size() == 1) {
+				work_available.notify_one();
+			}
+		}
+
+		std::lock_guard<std::mutex>	lock(mutex);
+
+		stats.nb_directories += thread_stats.nb_directories;
+		stats.nb_pruned_directories += thread_stats.nb_pruned_directories;
+		stats.nb_unreadable_directories += thread_stats.nb_unreadable_directories;
+		stats.nb_entries += thread_stats.nb_entries;
+		stats.nb_files += thread_stats.nb_files;
+	};
+
+	// The calling thread is one of the workers
+	std::vector<std::thread>	threads;
+
+	for (size_t i = 1; i < m_nb_threads; i++) {
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	// Depth first traversal in the order of the file system, like recursive_directory_iterator
+	std::vector<std::pair<const Walked_Directory*, size_t>>	stack;	// Directory and next entry
+
+	stack.emplace_back(&directories.front(), 0);
+	while (stack.empty() == false)
+	{
+		const Walked_Directory*	directory = stack.back().first;
+		size_t					entry_index = stack.back().second++;
+
+		if (entry_index == 0 && directories_paths) {
+			directories_paths->push_back(directory->path.length() > 1 ? directory->path.substr(0, directory->path.length() - 1) : directory->path);
+		}
+
+		if (entry_index >= directory->entries.size()) {
+			stack.pop_back();
+			continue;
+		}
+
+		const Walked_Entry&	entry = directory->entries[entry_index];
+
+		if (entry.directory) {
+			stack.emplace_back(entry.directory, 0);
+		}
+		else {
+			files.push_back(directory->path + entry.name);
+		}
+	}
+
+	m_stats.nb_directories += stats.nb_directories;
+	m_stats.nb_pruned_directories += stats.nb_pruned_directories;
+	m_stats.nb_unreadable_directories += stats.nb_unreadable_directories;
+	m_stats.nb_entries += stats.nb_entries;
+	m_stats.nb_files += stats.nb_files;
+	m_stats.duration += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	return root_read;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// List files of a directory tree with many threads, directories are shared by threads through a work queue
+/// On Linux directories are read with openat and getdents64, the type of entries comes from d_type (stat is only needed
+/// for symbolic links and file systems that don't fill it), elsewhere with std::filesystem::directory_iterator
+/// Files are given in the order of std::filesystem::recursive_directory_iterator (depth first, in the order of the
+/// file system), whatever the number of threads
+/// @Warning like recursive_directory_iterator, symbolic links to directories aren't followed, symbolic links to regular files
+/// are files, unreadable directories are skipped
+class Directory_Walker
+{
+public:
+	struct Stats
+	{
+		size_t	nb_directories = 0;				// Read directories (one open and a few getdents each)
+		size_t	nb_pruned_directories = 0;		// Not entered, refused by the directory filter
+		size_t	nb_unreadable_directories = 0;
+		size_t	nb_entries = 0;					// All entries of read directories
+		size_t	nb_files = 0;					// Accepted by the file filter
+		double	duration = 0.0;					// In seconds
+	};
+
+	/// Called with the name of entries (not the path), from all threads at once
+	using Name_Filter = std::function<bool(std::string_view name)>;
+
+	/// 0 thread is a thread per hardware thread
+	explicit Directory_Walker(size_t nb_threads = 0);
+
+	/// Append paths (generic format, root included) of files under root accepted by file_filter, directories refused by
+	/// directory_filter aren't read (a null filter accepts everything)
+	/// Paths of entered directories (root included, without a trailing '/') are appended to directories if it isn't null
+	/// Return false if root can't be read
+	bool			walk(const std::filesystem::path& root, const Name_Filter& file_filter, const Name_Filter& directory_filter, std::vector<std::string>& files,
+						 std::vector<std::string>* directories = nullptr);
+
+	size_t			nb_threads() const { return m_nb_threads; }
+	const Stats&	stats() const { return m_stats; }
+
+private:
+	size_t	m_nb_threads;
+	Stats	m_stats;	// Of all walks
+};
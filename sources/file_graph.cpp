@@ -0,0 +1,58 @@
+#include "file_graph.hpp"
+
+#include <algorithm>
+
+Node_Id File_Graph::add_node(Path_Id label, Path_Id path, Path_Id directory, File_Type file_type, bool file_found)
+{
+	Node_Attributes	attributes;
+
+	attributes.file_type = file_type;
+	attributes.file_found = file_found;
+	m_attributes.push_back(attributes);
+	m_paths.push_back(Node_Paths{label, path, directory});
+	return (Node_Id)(m_attributes.size() - 1);
+}
+
+/// Counting sort of edges by their parent (or child), stable so edges of a node keep their order
+void File_Graph::build_adjacency(bool by_parent, uint32_t*& offsets, Node_Id*& targets)
+{
+	size_t	nb_nodes = m_attributes.size();
+
+	offsets = m_arena.allocate<uint32_t>(nb_nodes + 1);
+	targets = m_arena.allocate<Node_Id>(m_edges.size());
+
+	std::fill(offsets, offsets + nb_nodes + 1, 0);
+	for (const auto& edge : m_edges) {
+		offsets[(by_parent ? edge.first : edge.second) + 1]++;
+	}
+	for (size_t node = 0; node < nb_nodes; node++) {
+		offsets[node + 1] += offsets[node];
+	}
+
+	std::vector<uint32_t>	positions(offsets, offsets + nb_nodes);
+
+	for (const auto& edge : m_edges) {
+		targets[positions[by_parent ? edge.first : edge.second]++] = by_parent ? edge.second : edge.first;
+	}
+}
+
+void File_Graph::freeze()
+{
+	build_adjacency(true, m_child_offsets, m_children);
+	build_adjacency(false, m_parent_offsets, m_parents);
+	m_nb_edges = m_edges.size();
+	std::vector<std::pair<Node_Id, Node_Id>>().swap(m_edges);	// @Warning clear doesn't release the memory
+}
+
+void File_Graph::ancestors(const std::vector<Node_Id>& nodes, std::vector<Node_Id>& reached) const
+{
+	find_ancestors(*this, nodes, reached);
+}
+
+size_t File_Graph::memory_usage() const
+{
+	return m_attributes.capacity() * sizeof(Node_Attributes)
+		+ m_paths.capacity() * sizeof(Node_Paths)
+		+ m_edges.capacity() * sizeof(std::pair<Node_Id, Node_Id>)
+		+ (is_frozen() ? 2 * ((nb_nodes() + 1) * sizeof(uint32_t) + m_nb_edges * sizeof(Node_Id)) : 0);
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "path_table.hpp"
+#include "utilities.hpp"
+
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <stdint.h>
+
+using Node_Id = uint32_t;
+
+constexpr Node_Id	invalid_node_id = UINT32_MAX;
+
+enum class File_Type : uint8_t {
+	not_supported,
+	source,
+	header
+};
+
+/// Attributes read by traversals and statistics, packed to have many nodes per cache line
+struct Node_Attributes {
+	uint32_t	nb_lines = 0;
+	File_Type	file_type = File_Type::not_supported;
+	bool		file_found = false;
+};
+
+/// Attributes only read to resolve includes of the node and to print it
+struct Node_Paths {
+	Path_Id		label;			// Relative header_path
+	Path_Id		path;
+	Path_Id		directory;		// Parent directory, includes are resolved from it
+};
+
+/// Texts of Node_Paths, to print or save a graph without the path table (it is shared by projects and grows)
+/// @Warning views in the arena of the path table, valid as long as the table
+struct Node_Texts {
+	std::string_view	label;
+	std::string_view	path;
+};
+
+/// Contiguous node ids, children or parents of a node
+class Node_Range
+{
+public:
+	Node_Range(const Node_Id* first, const Node_Id* last) : m_first(first), m_last(last) {}
+
+	const Node_Id*	begin() const { return m_first; }
+	const Node_Id*	end() const { return m_last; }
+	size_t			size() const { return m_last - m_first; }
+
+private:
+	const Node_Id*	m_first;
+	const Node_Id*	m_last;
+};
+
+/// Graph of files linked by includes
+/// Nodes and edges are added while includes are followed, then the graph is frozen in a compressed sparse row layout:
+/// children (and parents) of all nodes are in a single array, those of a node are contiguous and found by an offset, so
+/// an edge costs 4 bytes in each direction
+/// Node ids are dense in creation order (it gives their unique name), attributes are in arrays indexed by id, split in
+/// hot and cold ones
+/// Adjacency arrays are allocated in the arena of the project, they are released with it
+/// @Warning edges can't be added once the graph is frozen, children and parents aren't known before
+class File_Graph
+{
+public:
+	explicit File_Graph(Arena& arena) : m_arena(arena) {}
+
+	Node_Id					add_node(Path_Id label, Path_Id path, Path_Id directory, File_Type file_type, bool file_found);
+
+	/// Edges of a node keep the order in which they are added
+	void					add_edge(Node_Id parent, Node_Id child) { m_edges.emplace_back(parent, child); }
+
+	/// Build adjacency arrays from edges
+	void					freeze();
+	bool					is_frozen() const { return m_child_offsets != nullptr; }
+
+	size_t					nb_nodes() const { return m_attributes.size(); }
+	size_t					nb_edges() const { return is_frozen() ? m_nb_edges : m_edges.size(); }
+
+	Node_Attributes&		attributes(Node_Id node) { return m_attributes[node]; }
+	const Node_Attributes&	attributes(Node_Id node) const { return m_attributes[node]; }
+	const Node_Paths&		paths(Node_Id node) const { return m_paths[node]; }
+
+	Node_Range				children(Node_Id node) const { return Node_Range(m_children + m_child_offsets[node], m_children + m_child_offsets[node + 1]); }
+	Node_Range				parents(Node_Id node) const { return Node_Range(m_parents + m_parent_offsets[node], m_parents + m_parent_offsets[node + 1]); }
+	size_t					nb_inclusions(Node_Id node) const { return m_parent_offsets[node + 1] - m_parent_offsets[node]; }
+
+	/// Append nodes from which one of the given nodes is reachable (they are included), see find_ancestors
+	/// @Warning the graph has to be frozen
+	void					ancestors(const std::vector<Node_Id>& nodes, std::vector<Node_Id>& reached) const;
+
+	/// Return the number of bytes used by the graph (in the arena or not)
+	size_t					memory_usage() const;
+
+private:
+	void					build_adjacency(bool by_parent, uint32_t*& offsets, Node_Id*& targets);
+
+	Arena&										m_arena;
+	std::vector<Node_Attributes>				m_attributes;		// Hot, by node
+	std::vector<Node_Paths>						m_paths;			// Cold, by node
+	std::vector<std::pair<Node_Id, Node_Id>>	m_edges;			// Parent and child, released by freeze
+	size_t										m_nb_edges = 0;
+	uint32_t*									m_child_offsets = nullptr;	// nb_nodes + 1 offsets in m_children
+	Node_Id*									m_children = nullptr;
+	uint32_t*									m_parent_offsets = nullptr;	// nb_nodes + 1 offsets in m_parents
+	Node_Id*									m_parents = nullptr;
+};
+
+/// Append nodes from which one of the given nodes is reachable (they are included), each once, in breadth first order
+/// It is a single breadth first search from all given nodes at once, following parents
+/// The graph is a frozen File_Graph or a Graph_Snapshot, the same query is answered from memory or from the last run
+template<typename Graph>
+void find_ancestors(const Graph& graph, const std::vector<Node_Id>& nodes, std::vector<Node_Id>& reached)
+{
+	std::vector<bool>	visited(graph.nb_nodes(), false);	// A bit per node
+	size_t				next = reached.size();				// Reached nodes are the queue
+
+	for (Node_Id node : nodes)
+	{
+		if (visited[node] == false) {
+			visited[node] = true;
+			reached.push_back(node);
+		}
+	}
+	while (next < reached.size())
+	{
+		for (Node_Id parent : graph.parents(reached[next++]))
+		{
+			if (visited[parent] == false) {
+				visited[parent] = true;
+				reached.push_back(parent);
+			}
+		}
+	}
+}
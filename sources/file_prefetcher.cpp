@@ -0,0 +1,594 @@
+#include "file_prefetcher.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__linux__) && defined(__has_include)
+#	if __has_include(<linux/io_uring.h>)
+#		define PREFETCHER_IO_URING
+#	endif
+#endif
+
+#if defined(PREFETCHER_IO_URING)
+#	include <linux/io_uring.h>
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+#	include <cerrno>
+#	include <cstring>
+#endif
+
+namespace fs = std::filesystem;
+
+class File_Prefetcher::Implementation
+{
+public:
+	virtual ~Implementation() = default;
+
+	/// Return false if the file isn't prefetched (already prefetched, or too many files are prefetched)
+	virtual bool	prefetch(const fs::path& file_path) = 0;
+
+	/// Return false if the file wasn't prefetched (opened is then false), else opened is the result of the read
+	virtual bool	take(const fs::path& file_path, File_View& file, bool& opened) = 0;
+};
+
+//=============================================================================
+// Thread pool
+//=============================================================================
+
+class Thread_Pool_Prefetcher : public File_Prefetcher::Implementation
+{
+	struct Request
+	{
+		File_View	file;
+		bool		started = false;
+		bool		done = false;
+		bool		opened = false;
+	};
+
+public:
+	Thread_Pool_Prefetcher(size_t max_prefetched_files, size_t nb_threads)
+		: m_max_prefetched_files(max_prefetched_files)
+	{
+		for (size_t i = 0; i < nb_threads; i++) {
+			m_threads.emplace_back([this]() { work(); });
+		}
+	}
+
+	~Thread_Pool_Prefetcher() override
+	{
+		{
+			std::lock_guard<std::mutex>	lock(m_mutex);
+
+			m_stop = true;
+		}
+		m_work_available.notify_all();
+		for (std::thread& thread : m_threads) {
+			thread.join();
+		}
+	}
+
+	bool	prefetch(const fs::path& file_path) override
+	{
+		{
+			std::lock_guard<std::mutex>	lock(m_mutex);
+
+			if (m_requests.size() >= m_max_prefetched_files
+				|| m_requests.find(file_path.native()) != m_requests.end()) {
+				return false;
+			}
+
+			m_requests.emplace(file_path.native(), std::make_unique<Request>());
+			m_queue.push_back(file_path.native());
+		}
+		m_work_available.notify_one();
+		return true;
+	}
+
+	bool	take(const fs::path& file_path, File_View& file, bool& opened) override
+	{
+		std::unique_lock<std::mutex>	lock(m_mutex);
+		auto							it = m_requests.find(file_path.native());
+
+		if (it == m_requests.end()) {
+			return false;
+		}
+
+		Request*	request = it->second.get();
+
+		if (request->started == false)	// Still in the queue, it is faster to read it now
+		{
+			m_requests.erase(it);	// @Warning the path stays in the queue, it is skipped by workers
+			return false;
+		}
+
+		m_work_done.wait(lock, [request]() { return request->done; });
+		file = std::move(request->file);
+		opened = request->opened;
+		m_requests.erase(file_path.native());
+		return true;
+	}
+
+private:
+	void	work()
+	{
+		std::unique_lock<std::mutex>	lock(m_mutex);
+
+		while (true)
+		{
+			m_work_available.wait(lock, [this]() { return m_stop || m_queue.empty() == false; });
+			if (m_stop) {
+				return;
+			}
+
+			fs::path::string_type	path = std::move(m_queue.front());
+			auto					it = m_requests.find(path);
+
+			m_queue.pop_front();
+			if (it == m_requests.end() || it->second->started) {
+				continue;	// Already taken
+			}
+
+			Request*	request = it->second.get();
+			File_View	file;
+			bool		opened;
+
+			request->started = true;
+			lock.unlock();
+			opened = file.open(path);
+			lock.lock();
+
+			request->file = std::move(file);
+			request->opened = opened;
+			request->done = true;
+			m_work_done.notify_all();
+		}
+	}
+
+	size_t																m_max_prefetched_files;
+	std::mutex															m_mutex;
+	std::condition_variable												m_work_available;
+	std::condition_variable												m_work_done;
+	std::deque<fs::path::string_type>									m_queue;	// Paths of files to read
+	std::unordered_map<fs::path::string_type, std::unique_ptr<Request>>	m_requests;	// Queued, being read, or read and not taken yet
+	std::vector<std::thread>											m_threads;
+	bool																m_stop = false;
+};
+
+//=============================================================================
+// io_uring
+//=============================================================================
+
+#if defined(PREFETCHER_IO_URING)
+
+/// The ring is used without liburing: the setup maps the submission and completion queues shared with the kernel,
+/// requests go through 2 steps (openat, then reads until the whole file is in the buffer)
+/// Completions are reaped by the thread that calls prefetch and open, there is no thread
+class Io_Uring_Prefetcher : public File_Prefetcher::Implementation
+{
+	static constexpr unsigned	queue_depth = 64;	// Maximum number of requests in flight
+
+	struct Request
+	{
+		enum class Stage : uint8_t
+		{
+			waiting,	// Not submitted (the queue is full)
+			opening,
+			reading,
+			done
+		};
+
+		fs::path::string_type	path;
+		Stage					stage = Stage::waiting;
+		int						fd = -1;
+		std::unique_ptr<char[]>	buffer;
+		size_t					size = 0;
+		size_t					read_size = 0;
+		bool					opened = false;
+	};
+
+public:
+	static bool	is_supported()
+	{
+		static const bool	supported = []() {
+			Io_Uring_Prefetcher	prefetcher(1);
+
+			return prefetcher.m_ring_fd >= 0;
+		}();
+		return supported;
+	}
+
+	explicit Io_Uring_Prefetcher(size_t max_prefetched_files)
+		: m_max_prefetched_files(max_prefetched_files)
+	{
+		io_uring_params	params = {};
+
+		m_ring_fd = (int)syscall(__NR_io_uring_setup, queue_depth, &params);
+		if (m_ring_fd < 0) {
+			return;
+		}
+
+		if ((params.features & IORING_FEAT_SINGLE_MMAP) == 0
+			|| map_rings(params) == false
+			|| supports_operations() == false)
+		{
+			release();
+		}
+	}
+
+	~Io_Uring_Prefetcher() override
+	{
+		// @Warning the kernel writes in buffers of requests in flight
+		m_waiting.clear();
+		while (m_nb_in_flight > 0) {
+			reap(true);
+		}
+		for (auto& pair : m_requests) {
+			if (pair.second->fd >= 0) {
+				::close(pair.second->fd);
+			}
+		}
+		release();
+	}
+
+	bool	prefetch(const fs::path& file_path) override
+	{
+		if (m_requests.size() >= m_max_prefetched_files
+			|| m_requests.find(file_path.native()) != m_requests.end()) {
+			return false;
+		}
+
+		std::unique_ptr<Request>	request = std::make_unique<Request>();
+
+		request->path = file_path.native();
+		if (m_nb_in_flight < queue_depth) {
+			submit_open(request.get());
+		}
+		else {
+			m_waiting.push_back(request.get());
+		}
+		m_requests.emplace(file_path.native(), std::move(request));
+		return true;	// @Warning submitted with the next open, so includes of a file are submitted in one batch
+	}
+
+	bool	take(const fs::path& file_path, File_View& file, bool& opened) override
+	{
+		reap(false);	// Submit prefetched files and process completions
+
+		auto	it = m_requests.find(file_path.native());
+
+		if (it == m_requests.end()) {
+			return false;
+		}
+
+		Request*	request = it->second.get();
+
+		if (request->stage == Request::Stage::waiting)
+		{
+			m_waiting.erase(std::find(m_waiting.begin(), m_waiting.end(), request));
+			m_requests.erase(it);
+			return false;
+		}
+
+		while (request->stage != Request::Stage::done) {
+			reap(true);
+		}
+
+		opened = request->opened;
+		if (opened) {
+			file.adopt(std::move(request->buffer), request->read_size);
+		}
+		m_requests.erase(it);
+		return true;
+	}
+
+private:
+	bool	map_rings(const io_uring_params& params)
+	{
+		m_rings_size = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+			params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+		m_rings = mmap(nullptr, m_rings_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_SQ_RING);
+		if (m_rings == MAP_FAILED)
+		{
+			m_rings = nullptr;
+			return false;
+		}
+
+		m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+		m_sqes = static_cast<io_uring_sqe*>(mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_SQES));
+		if (m_sqes == MAP_FAILED)
+		{
+			m_sqes = nullptr;
+			return false;
+		}
+
+		char*	rings = static_cast<char*>(m_rings);
+
+		m_sq_head = reinterpret_cast<unsigned*>(rings + params.sq_off.head);
+		m_sq_tail = reinterpret_cast<unsigned*>(rings + params.sq_off.tail);
+		m_sq_local_tail = *m_sq_tail;
+		m_sq_mask = *reinterpret_cast<unsigned*>(rings + params.sq_off.ring_mask);
+		m_sq_array = reinterpret_cast<unsigned*>(rings + params.sq_off.array);
+		m_cq_head = reinterpret_cast<unsigned*>(rings + params.cq_off.head);
+		m_cq_tail = reinterpret_cast<unsigned*>(rings + params.cq_off.tail);
+		m_cq_mask = *reinterpret_cast<unsigned*>(rings + params.cq_off.ring_mask);
+		m_cqes = reinterpret_cast<io_uring_cqe*>(rings + params.cq_off.cqes);
+		return true;
+	}
+
+	bool	supports_operations()
+	{
+		const unsigned					nb_operations = 256;
+		std::vector<char>				probe_buffer(sizeof(io_uring_probe) + nb_operations * sizeof(io_uring_probe_op), 0);
+		io_uring_probe*					probe = reinterpret_cast<io_uring_probe*>(probe_buffer.data());
+
+		if (syscall(__NR_io_uring_register, m_ring_fd, IORING_REGISTER_PROBE, probe, nb_operations) < 0) {
+			return false;
+		}
+
+		auto	is_supported = [probe](unsigned operation) {
+			return operation <= probe->last_op && (probe->ops[operation].flags & IO_URING_OP_SUPPORTED);
+		};
+		return is_supported(IORING_OP_OPENAT) && is_supported(IORING_OP_READ);
+	}
+
+	void	release()
+	{
+		if (m_sqes) {
+			munmap(m_sqes, m_sqes_size);
+		}
+		if (m_rings) {
+			munmap(m_rings, m_rings_size);
+		}
+		if (m_ring_fd >= 0) {
+			::close(m_ring_fd);
+		}
+		m_sqes = nullptr;
+		m_rings = nullptr;
+		m_ring_fd = -1;
+	}
+
+	io_uring_sqe*	get_sqe(Request* request)
+	{
+		unsigned		index = m_sq_local_tail & m_sq_mask;
+		io_uring_sqe*	sqe = &m_sqes[index];
+
+		std::memset(sqe, 0, sizeof(io_uring_sqe));
+		sqe->user_data = reinterpret_cast<uint64_t>(request);
+		m_sq_array[index] = index;
+		m_sq_local_tail++;
+		return sqe;
+	}
+
+	void	submit_open(Request* request)
+	{
+		io_uring_sqe*	sqe = get_sqe(request);
+
+		sqe->opcode = IORING_OP_OPENAT;
+		sqe->fd = AT_FDCWD;
+		sqe->addr = reinterpret_cast<uint64_t>(request->path.c_str());
+		sqe->open_flags = O_RDONLY | O_CLOEXEC;
+		request->stage = Request::Stage::opening;
+		m_nb_in_flight++;
+	}
+
+	void	submit_read(Request* request)
+	{
+		io_uring_sqe*	sqe = get_sqe(request);
+
+		sqe->opcode = IORING_OP_READ;
+		sqe->fd = request->fd;
+		sqe->addr = reinterpret_cast<uint64_t>(request->buffer.get() + request->read_size);
+		sqe->len = (uint32_t)std::min<size_t>(request->size - request->read_size, 1u << 30);
+		sqe->off = request->read_size;
+		request->stage = Request::Stage::reading;
+		m_nb_in_flight++;
+	}
+
+	/// Submit written entries, and wait for a completion if wait is true and there is none
+	void	submit(bool wait = false)
+	{
+		__atomic_store_n(m_sq_tail, m_sq_local_tail, __ATOMIC_RELEASE);
+		while (true)
+		{
+			unsigned	nb_to_submit = m_sq_local_tail - __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+			bool		has_to_wait = wait && m_nb_in_flight > 0 && __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE) == *m_cq_head;
+
+			if (nb_to_submit == 0 && has_to_wait == false) {
+				return;
+			}
+			if (syscall(__NR_io_uring_enter, m_ring_fd, nb_to_submit, has_to_wait ? 1 : 0, has_to_wait ? IORING_ENTER_GETEVENTS : 0, nullptr, 0) < 0
+				&& errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+				return;	// @Warning entries stay in the ring, they will be submitted by the next call
+			}
+			wait = false;	// At least one completion is available or the call was interrupted
+		}
+	}
+
+	void	finish(Request* request, bool opened)
+	{
+		if (request->fd >= 0)
+		{
+			::close(request->fd);
+			request->fd = -1;
+		}
+		request->opened = opened;
+		request->stage = Request::Stage::done;
+
+		if (m_waiting.empty() == false)
+		{
+			submit_open(m_waiting.front());
+			m_waiting.pop_front();
+		}
+	}
+
+	void	complete(Request* request, int result)
+	{
+		m_nb_in_flight--;
+
+		if (result == -EINTR || result == -EAGAIN)	// Retry
+		{
+			if (request->stage == Request::Stage::opening) {
+				submit_open(request);
+			}
+			else {
+				submit_read(request);
+			}
+			return;
+		}
+
+		if (result < 0) {
+			finish(request, false);
+			return;
+		}
+
+		if (request->stage == Request::Stage::opening)
+		{
+			struct stat	file_status;
+
+			request->fd = result;
+			if (fstat(request->fd, &file_status) != 0
+				|| S_ISREG(file_status.st_mode) == false) {	// @Warning directories can be opened
+				finish(request, false);
+				return;
+			}
+
+			request->size = (size_t)file_status.st_size;
+			request->buffer.reset(new char[request->size]);
+			if (request->size == 0) {
+				finish(request, true);
+			}
+			else {
+				submit_read(request);
+			}
+		}
+		else
+		{
+			request->read_size += (size_t)result;
+			if (result == 0 || request->read_size == request->size) {	// @Warning 0 if the file was truncated
+				finish(request, true);
+			}
+			else {
+				submit_read(request);
+			}
+		}
+	}
+
+	/// Process available completions, if wait is true at least one completion is waited for
+	void	reap(bool wait)
+	{
+		submit(wait);
+
+		unsigned	head = *m_cq_head;
+		unsigned	tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+
+		for (; head != tail; head++)
+		{
+			const io_uring_cqe&	cqe = m_cqes[head & m_cq_mask];
+
+			complete(reinterpret_cast<Request*>(cqe.user_data), cqe.res);
+		}
+		__atomic_store_n(m_cq_head, head, __ATOMIC_RELEASE);
+		submit();	// Reads of opened files (they are waited with the next call)
+	}
+
+	size_t															m_max_prefetched_files;
+	int																m_ring_fd = -1;
+	void*															m_rings = nullptr;
+	size_t															m_rings_size = 0;
+	io_uring_sqe*													m_sqes = nullptr;
+	size_t															m_sqes_size = 0;
+	unsigned*														m_sq_head = nullptr;
+	unsigned*														m_sq_tail = nullptr;
+	unsigned														m_sq_mask = 0;
+	unsigned*														m_sq_array = nullptr;
+	unsigned*														m_cq_head = nullptr;
+	unsigned*														m_cq_tail = nullptr;
+	unsigned														m_cq_mask = 0;
+	io_uring_cqe*													m_cqes = nullptr;
+	unsigned														m_sq_local_tail = 0;	// Entries written in the submission queue, the kernel sees them after submit
+	unsigned														m_nb_in_flight = 0;	// Submitted or to submit
+	std::deque<Request*>											m_waiting;
+	std::unordered_map<fs::path::string_type, std::unique_ptr<Request>>	m_requests;
+};
+
+#endif
+
+//=============================================================================
+// File_Prefetcher
+//=============================================================================
+
+static const size_t	thread_pool_nb_threads = 8;	// Reads wait for the I/O most of the time, there can be more threads than cores
+
+bool is_prefetch_backend_supported(Prefetch_Backend backend)
+{
+	switch (backend)
+	{
+	case Prefetch_Backend::synchronous:
+	case Prefetch_Backend::thread_pool:
+		return true;
+#if defined(PREFETCHER_IO_URING)
+	case Prefetch_Backend::io_uring:
+		return Io_Uring_Prefetcher::is_supported();	// @Warning it can be disabled by the kernel configuration or a seccomp filter
+#endif
+	default:
+		return false;
+	}
+}
+
+Prefetch_Backend best_prefetch_backend()
+{
+	if (is_prefetch_backend_supported(Prefetch_Backend::io_uring)) {
+		return Prefetch_Backend::io_uring;
+	}
+	return Prefetch_Backend::thread_pool;
+}
+
+File_Prefetcher::File_Prefetcher(Prefetch_Backend backend, size_t max_prefetched_files)
+	: m_backend(is_prefetch_backend_supported(backend) ? backend : Prefetch_Backend::thread_pool)
+{
+	switch (m_backend)
+	{
+	case Prefetch_Backend::thread_pool:
+		m_implementation = std::make_unique<Thread_Pool_Prefetcher>(max_prefetched_files, thread_pool_nb_threads);
+		break;
+#if defined(PREFETCHER_IO_URING)
+	case Prefetch_Backend::io_uring:
+		m_implementation = std::make_unique<Io_Uring_Prefetcher>(max_prefetched_files);
+		break;
+#endif
+	default:
+		break;
+	}
+}
+
+File_Prefetcher::~File_Prefetcher() = default;
+
+void File_Prefetcher::prefetch(const fs::path& file_path)
+{
+	if (m_implementation && m_implementation->prefetch(file_path)) {
+		m_stats.nb_prefetched++;
+	}
+}
+
+bool File_Prefetcher::open(const fs::path& file_path, File_View& file)
+{
+	bool	opened = false;
+
+	if (m_implementation && m_implementation->take(file_path, file, opened))
+	{
+		m_stats.nb_hits++;
+		return opened;
+	}
+
+	m_stats.nb_misses++;
+	return file.open(file_path);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "utilities.hpp"
+
+#include <filesystem>
+#include <memory>
+
+#include <stdint.h>
+
+enum class Prefetch_Backend : uint8_t
+{
+	synchronous,	// No prefetching, files are read when they are opened
+	thread_pool,	// Files are read by threads
+	io_uring		// Linux only, many reads are in flight without threads
+};
+
+bool				is_prefetch_backend_supported(Prefetch_Backend backend);
+Prefetch_Backend	best_prefetch_backend();
+
+/// Read files in background before they are needed, so the I/O latency (cold cache, network file systems)
+/// is hidden behind the parsing of other files
+/// Files are prefetched as soon as they are known (includes found in a file, next source file), and are
+/// given to the parser by open in any order
+/// @Warning prefetching is a hint, it is ignored when too many prefetched files aren't opened yet
+class File_Prefetcher
+{
+public:
+	struct Stats
+	{
+		size_t	nb_prefetched = 0;	// Files read in background
+		size_t	nb_hits = 0;		// Opened files that were prefetched
+		size_t	nb_misses = 0;		// Opened files that were read synchronously
+	};
+
+	class Implementation;
+
+	static constexpr size_t	default_max_prefetched_files = 256;
+
+	explicit File_Prefetcher(Prefetch_Backend backend = best_prefetch_backend(), size_t max_prefetched_files = default_max_prefetched_files);
+	~File_Prefetcher();
+
+	File_Prefetcher(const File_Prefetcher&) = delete;
+	File_Prefetcher&	operator=(const File_Prefetcher&) = delete;
+
+	/// Start to read the file in background
+	void				prefetch(const std::filesystem::path& file_path);
+
+	/// Give the content of the file, wait for it if it is being prefetched, or read it now
+	/// Return false if the file can't be read
+	bool				open(const std::filesystem::path& file_path, File_View& file);
+
+	Prefetch_Backend	backend() const { return m_backend; }
+	const Stats&		stats() const { return m_stats; }
+
+private:
+	Prefetch_Backend				m_backend;
+	std::unique_ptr<Implementation>	m_implementation;	// Null for the synchronous backend
+	Stats							m_stats;
+};
@@ -0,0 +1,433 @@
+#include "file_watcher.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <stdint.h>
+
+#if defined(__linux__)
+#	include <sys/inotify.h>
+#	include <poll.h>
+#	include <unistd.h>
+#	include <cerrno>
+#elif defined(_WIN32)
+#	define NOMINMAX
+#	define WIN32_LEAN_AND_MEAN
+#	include <windows.h>
+#endif
+
+namespace fs = std::filesystem;
+
+static void append_change(std::vector<File_Watcher::Change>& changes, const std::string& directory, std::string_view name)
+{
+	changes.push_back(File_Watcher::Change{directory, std::string(name)});
+}
+
+/// Keep the first occurrence of each change
+static void remove_duplicated_changes(std::vector<File_Watcher::Change>& changes, size_t first_change)
+{
+	std::unordered_set<std::string>	seen;
+	size_t							nb_kept = first_change;
+
+	for (size_t i = first_change; i < changes.size(); i++)
+	{
+		if (seen.insert(changes[i].directory + '/' + changes[i].name).second == false) {
+			continue;
+		}
+		if (nb_kept != i) {
+			changes[nb_kept] = std::move(changes[i]);	// @Warning not on itself, it would be emptied
+		}
+		nb_kept++;
+	}
+	changes.resize(nb_kept);
+}
+
+#if defined(__linux__)
+struct File_Watcher::Implementation
+{
+	static constexpr uint32_t	watch_mask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+
+	int													fd = -1;
+	std::unordered_map<int, std::vector<std::string>>	directories;	// By watch descriptor, the kernel gives the same one to all spellings of a directory
+	std::unordered_set<std::string>						watched;		// Spellings already given to watch
+};
+
+File_Watcher::File_Watcher()
+	: m_implementation(std::make_unique<Implementation>())
+{
+	m_implementation->fd = inotify_init1(IN_CLOEXEC);
+}
+
+File_Watcher::~File_Watcher()
+{
+	if (m_implementation->fd >= 0) {
+		close(m_implementation->fd);
+	}
+}
+
+bool File_Watcher::watch(std::string_view directory)
+{
+	Implementation&	implementation = *m_implementation;
+	std::string		path(directory);
+
+	if (implementation.watched.count(path)) {
+		return true;
+	}
+	if (implementation.fd < 0) {
+		return false;
+	}
+
+	int	watch_descriptor = inotify_add_watch(implementation.fd, path.c_str(), Implementation::watch_mask);
+
+	if (watch_descriptor < 0) {
+		return false;	// Not a directory, or fs.inotify.max_user_watches is reached
+	}
+	implementation.directories[watch_descriptor].push_back(path);
+	implementation.watched.insert(std::move(path));
+	return true;
+}
+
+bool File_Watcher::wait_changes(std::vector<Change>& changes, std::chrono::milliseconds settle_delay)
+{
+	Implementation&				implementation = *m_implementation;
+	alignas(inotify_event) char	buffer[64 * 1024];
+	size_t						first_change = changes.size();
+	bool						is_complete = true;
+	int							timeout = -1;	// The first change is waited without limit
+
+	if (implementation.fd < 0) {
+		return false;
+	}
+
+	for (;;)
+	{
+		pollfd	poll_descriptor = {implementation.fd, POLLIN, 0};
+		int		nb_ready = poll(&poll_descriptor, 1, timeout);
+
+		if (nb_ready < 0 && errno == EINTR) {
+			continue;
+		}
+		if (nb_ready <= 0) {
+			break;	// Settled
+		}
+
+		ssize_t	size = read(implementation.fd, buffer, sizeof(buffer));
+
+		if (size <= 0) {
+			break;
+		}
+		for (ssize_t position = 0; position < size; )
+		{
+			const inotify_event*	event = (const inotify_event*)(buffer + position);
+
+			position += sizeof(inotify_event) + event->len;
+			if (event->mask & IN_Q_OVERFLOW) {
+				is_complete = false;
+				continue;
+			}
+
+			auto	it = implementation.directories.find(event->wd);
+
+			if (it == implementation.directories.end()) {
+				continue;
+			}
+			if (event->mask & IN_IGNORED)	// The directory was removed (its parent reports it)
+			{
+				for (const std::string& directory : it->second) {
+					implementation.watched.erase(directory);
+				}
+				implementation.directories.erase(it);
+				continue;
+			}
+			if (event->len == 0) {
+				continue;	// An event of the directory itself
+			}
+			for (const std::string& directory : it->second) {
+				append_change(changes, directory, event->name);	// @Warning the name is padded with null characters
+			}
+		}
+		timeout = (int)settle_delay.count();
+	}
+
+	remove_duplicated_changes(changes, first_change);
+	return is_complete;
+}
+
+size_t File_Watcher::nb_watched_directories() const
+{
+	return m_implementation->watched.size();
+}
+#elif defined(_WIN32)
+struct File_Watcher::Implementation
+{
+	static constexpr DWORD	notify_filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE;
+
+	/// @Warning the kernel writes in the buffer and the overlapped structure until the read completes, a directory doesn't move
+	struct Directory
+	{
+		std::string				path;		// As given to watch
+		HANDLE					handle = INVALID_HANDLE_VALUE;
+		OVERLAPPED				overlapped = {};
+		alignas(DWORD) char		buffer[64 * 1024];	// @Warning 64 KB at most for directories on the network
+	};
+
+	HANDLE									port = nullptr;	// Reads of all directories complete on it (WaitForMultipleObjects is limited to 64 handles)
+	std::vector<std::unique_ptr<Directory>>	directories;	// By completion key, null once the directory is removed
+	std::unordered_set<std::string>			watched;		// Spellings already given to watch
+
+	/// Start the read of the next changes of the directory
+	static bool	read_changes(Directory& directory)
+	{
+		directory.overlapped = {};
+		return ReadDirectoryChangesW(directory.handle, directory.buffer, sizeof(directory.buffer), FALSE, notify_filter, nullptr, &directory.overlapped, nullptr) != FALSE;
+	}
+
+	/// Stop watching the directory, its read is canceled (and waited, the kernel uses its buffer)
+	void	remove_directory(size_t key)
+	{
+		Directory&	directory = *directories[key];
+		DWORD		size = 0;
+
+		if (CancelIoEx(directory.handle, &directory.overlapped)) {
+			GetOverlappedResult(directory.handle, &directory.overlapped, &size, TRUE);
+		}
+		CloseHandle(directory.handle);
+		watched.erase(directory.path);
+		directories[key].reset();
+	}
+};
+
+File_Watcher::File_Watcher()
+	: m_implementation(std::make_unique<Implementation>())
+{
+	m_implementation->port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+}
+
+File_Watcher::~File_Watcher()
+{
+	for (size_t key = 0; key < m_implementation->directories.size(); key++)
+	{
+		if (m_implementation->directories[key]) {
+			m_implementation->remove_directory(key);
+		}
+	}
+	if (m_implementation->port) {
+		CloseHandle(m_implementation->port);
+	}
+}
+
+bool File_Watcher::watch(std::string_view directory)
+{
+	Implementation&	implementation = *m_implementation;
+	std::string		path(directory);
+
+	if (implementation.watched.count(path)) {
+		return true;
+	}
+	if (implementation.port == nullptr) {
+		return false;
+	}
+
+	auto	watched_directory = std::make_unique<Implementation::Directory>();
+	size_t	key = implementation.directories.size();
+
+	watched_directory->path = path;
+	watched_directory->handle = CreateFileW(fs::path(path).c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+											FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);	// @Warning FILE_FLAG_BACKUP_SEMANTICS is needed to open a directory
+	if (watched_directory->handle == INVALID_HANDLE_VALUE) {
+		return false;	// Not a directory
+	}
+	if (CreateIoCompletionPort(watched_directory->handle, implementation.port, (ULONG_PTR)key, 0) == nullptr
+		|| Implementation::read_changes(*watched_directory) == false)
+	{
+		CloseHandle(watched_directory->handle);
+		return false;
+	}
+	implementation.directories.push_back(std::move(watched_directory));
+	implementation.watched.insert(std::move(path));
+	return true;
+}
+
+bool File_Watcher::wait_changes(std::vector<Change>& changes, std::chrono::milliseconds settle_delay)
+{
+	Implementation&	implementation = *m_implementation;
+	size_t			first_change = changes.size();
+	bool			is_complete = true;
+	DWORD			timeout = INFINITE;	// The first change is waited without limit
+
+	if (implementation.port == nullptr) {
+		return false;
+	}
+
+	for (;;)
+	{
+		DWORD			size = 0;
+		ULONG_PTR		key = 0;
+		OVERLAPPED*		overlapped = nullptr;
+		BOOL			succeeded = GetQueuedCompletionStatus(implementation.port, &size, &key, &overlapped, timeout);
+
+		if (overlapped == nullptr) {
+			break;	// Settled
+		}
+		timeout = (DWORD)settle_delay.count();
+		if (key >= implementation.directories.size() || implementation.directories[key] == nullptr) {
+			continue;
+		}
+
+		Implementation::Directory&	directory = *implementation.directories[key];
+
+		if ((succeeded && size == 0) || (succeeded == false && GetLastError() == ERROR_NOTIFY_ENUM_DIR))
+		{
+			is_complete = false;	// The buffer overflowed, changes of this read are lost
+			succeeded = TRUE;
+			size = 0;
+		}
+		for (DWORD position = 0; succeeded && size != 0; )
+		{
+			const FILE_NOTIFY_INFORMATION*	information = (const FILE_NOTIFY_INFORMATION*)(directory.buffer + position);
+			std::wstring_view				name(information->FileName, information->FileNameLength / sizeof(WCHAR));	// @Warning not null terminated
+
+			append_change(changes, directory.path, fs::path(name).string());
+			if (information->NextEntryOffset == 0) {
+				break;
+			}
+			position += information->NextEntryOffset;
+		}
+
+		if (succeeded == false || Implementation::read_changes(directory) == false) {
+			implementation.remove_directory(key);	// The directory was removed (its parent reports it)
+		}
+	}
+
+	remove_duplicated_changes(changes, first_change);
+	return is_complete;
+}
+
+size_t File_Watcher::nb_watched_directories() const
+{
+	return m_implementation->watched.size();
+}
+#else
+struct File_Watcher::Implementation
+{
+	static constexpr std::chrono::milliseconds	poll_interval{250};
+
+	struct Entry_State
+	{
+		uintmax_t				size;
+		fs::file_time_type		modification_time;
+	};
+
+	using Snapshot = std::unordered_map<std::string, Entry_State>;	// By name
+
+	std::unordered_map<std::string, Snapshot>	directories;	// Entries of the last poll
+
+	static bool	take_snapshot(const std::string& directory, Snapshot& snapshot)
+	{
+		std::error_code	error;
+
+		snapshot.clear();
+		fs::directory_iterator	it(fs::path(directory), error);
+		if (error) {
+			return false;
+		}
+		for (fs::directory_iterator end; !error && it != end; it.increment(error))
+		{
+			std::error_code	status_error;
+			Entry_State		state;
+
+			state.size = it->is_regular_file(status_error) ? it->file_size(status_error) : 0;
+			state.modification_time = it->last_write_time(status_error);
+			snapshot.emplace(it->path().filename().string(), state);
+		}
+		return true;
+	}
+};
+
+File_Watcher::File_Watcher()
+	: m_implementation(std::make_unique<Implementation>())
+{
+}
+
+File_Watcher::~File_Watcher() = default;
+
+bool File_Watcher::watch(std::string_view directory)
+{
+	std::string	path(directory);
+
+	if (m_implementation->directories.count(path)) {
+		return true;
+	}
+
+	Implementation::Snapshot	snapshot;
+
+	if (Implementation::take_snapshot(path, snapshot) == false) {
+		return false;
+	}
+	m_implementation->directories.emplace(std::move(path), std::move(snapshot));
+	return true;
+}
+
+bool File_Watcher::wait_changes(std::vector<Change>& changes, std::chrono::milliseconds settle_delay)
+{
+	Implementation&							implementation = *m_implementation;
+	size_t									first_change = changes.size();
+	Implementation::Snapshot				snapshot;
+	std::chrono::steady_clock::time_point	last_change_time;
+	std::vector<std::string>				removed_directories;
+
+	for (;;)
+	{
+		std::this_thread::sleep_for(Implementation::poll_interval);
+
+		size_t	nb_changes = changes.size();
+
+		removed_directories.clear();
+		for (auto& directory : implementation.directories)
+		{
+			if (Implementation::take_snapshot(directory.first, snapshot) == false) {
+				removed_directories.push_back(directory.first);	// Its parent reports it
+				continue;
+			}
+			for (const auto& entry : snapshot)
+			{
+				auto	previous = directory.second.find(entry.first);
+
+				if (previous == directory.second.end()
+					|| previous->second.size != entry.second.size
+					|| previous->second.modification_time != entry.second.modification_time) {
+					append_change(changes, directory.first, entry.first);
+				}
+			}
+			for (const auto& entry : directory.second)
+			{
+				if (snapshot.count(entry.first) == 0) {
+					append_change(changes, directory.first, entry.first);
+				}
+			}
+			directory.second.swap(snapshot);
+		}
+		for (const std::string& directory : removed_directories) {
+			implementation.directories.erase(directory);
+		}
+
+		if (changes.size() != nb_changes) {
+			last_change_time = std::chrono::steady_clock::now();
+		}
+		else if (changes.size() != first_change && std::chrono::steady_clock::now() - last_change_time >= settle_delay) {
+			break;
+		}
+	}
+
+	remove_duplicated_changes(changes, first_change);
+	return true;
+}
+
+size_t File_Watcher::nb_watched_directories() const
+{
+	return m_implementation->directories.size();
+}
+#endif
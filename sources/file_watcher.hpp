@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Notify changes of entries of directories (created, modified, removed or renamed files and directories)
+/// On Linux changes come from inotify, on Windows from ReadDirectoryChangesW, the process sleeps until the kernel reports
+/// them, elsewhere watched directories are polled and their entries compared to the previous poll (size and modification time)
+/// @Warning a directory is watched without its subdirectories, each one has to be watched
+class File_Watcher
+{
+public:
+	struct Change
+	{
+		std::string	directory;	// As given to watch
+		std::string	name;		// Of the entry in the directory
+	};
+
+	struct Implementation;
+
+	File_Watcher();
+	~File_Watcher();
+
+	File_Watcher(const File_Watcher&) = delete;
+	File_Watcher&	operator=(const File_Watcher&) = delete;
+
+	/// Return false if the directory can't be watched (it doesn't exist, or the limit of watches of the system is reached)
+	/// A directory is watched once, even if it is given many times (or with another spelling on Linux)
+	bool			watch(std::string_view directory);
+
+	/// Wait for a change, then for settle_delay without any other change (saving a file is often many events)
+	/// Append changes, an entry changed many times is given once
+	/// Return false if some changes are lost (the queue of the kernel overflowed), everything has to be considered changed
+	bool			wait_changes(std::vector<Change>& changes, std::chrono::milliseconds settle_delay);
+
+	size_t			nb_watched_directories() const;
+
+private:
+	std::unique_ptr<Implementation>	m_implementation;
+};
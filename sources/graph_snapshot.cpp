@@ -0,0 +1,231 @@
+#include "graph_snapshot.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+static constexpr char		graph_snapshot_magic[8] = {'I', 'N', 'C', 'G', 'G', 'R', 'P', 'H'};
+static constexpr uint32_t	graph_snapshot_version = 1;	// @Warning to increment when the format changes
+
+/// The file is the header, nodes, root nodes, child offsets, children, parent offsets, parents, then texts of paths
+/// All sections are arrays of 4 bytes aligned records, so they are aligned in the mapping
+struct Graph_Snapshot::Header
+{
+	char		magic[8];
+	uint32_t	version;
+	uint32_t	nb_nodes;
+	uint32_t	nb_edges;
+	uint32_t	nb_root_nodes;
+	uint64_t	strings_size;
+};
+
+struct Graph_Snapshot::Node
+{
+	uint32_t	label_offset;	// In texts
+	uint32_t	label_length;
+	uint32_t	path_offset;
+	uint32_t	path_length;
+	uint32_t	nb_lines;
+	uint32_t	nb_inclusions;
+	uint8_t		file_type;		// File_Type
+	uint8_t		file_found;
+	uint8_t		padding[2];
+};
+
+uint64_t Graph_Snapshot::sections_size(uint64_t nb_nodes, uint64_t nb_edges, uint64_t nb_root_nodes)
+{
+	static_assert(sizeof(Header) % 4 == 0 && sizeof(Node) % 4 == 0, "Sections have to stay aligned");
+
+	return sizeof(Header)
+		+ nb_nodes * sizeof(Node)
+		+ nb_root_nodes * sizeof(Node_Id)
+		+ 2 * ((nb_nodes + 1) * sizeof(uint32_t) + nb_edges * sizeof(Node_Id));
+}
+
+void Graph_Snapshot::close()
+{
+	m_nodes = nullptr;
+	m_nb_nodes = 0;
+	m_nb_edges = 0;
+	m_root_nodes = nullptr;
+	m_nb_root_nodes = 0;
+	m_child_offsets = nullptr;
+	m_children = nullptr;
+	m_parent_offsets = nullptr;
+	m_parents = nullptr;
+	m_strings = nullptr;
+	m_strings_size = 0;
+	m_file.close();
+}
+
+bool Graph_Snapshot::load(const fs::path& file_path)
+{
+	close();
+	if (m_file.open(file_path, File_View::Access::random) == false) {
+		return false;
+	}
+
+	std::string_view	data = m_file.view();
+	Header				header;
+
+	if (data.size() < sizeof(Header)) {
+		close();
+		return false;
+	}
+	memcpy(&header, data.data(), sizeof(Header));
+	if (memcmp(header.magic, graph_snapshot_magic, sizeof(graph_snapshot_magic)) != 0
+		|| header.version != graph_snapshot_version
+		|| data.size() != sections_size(header.nb_nodes, header.nb_edges, header.nb_root_nodes) + header.strings_size) {
+		close();
+		return false;
+	}
+
+	const char*	position = data.data() + sizeof(Header);
+
+	m_nb_nodes = header.nb_nodes;
+	m_nb_edges = header.nb_edges;
+	m_nb_root_nodes = header.nb_root_nodes;
+	m_strings_size = (size_t)header.strings_size;
+	m_nodes = (const Node*)position;
+	position += m_nb_nodes * sizeof(Node);
+	m_root_nodes = (const Node_Id*)position;
+	position += m_nb_root_nodes * sizeof(Node_Id);
+	m_child_offsets = (const uint32_t*)position;
+	position += (m_nb_nodes + 1) * sizeof(uint32_t);
+	m_children = (const Node_Id*)position;
+	position += m_nb_edges * sizeof(Node_Id);
+	m_parent_offsets = (const uint32_t*)position;
+	position += (m_nb_nodes + 1) * sizeof(uint32_t);
+	m_parents = (const Node_Id*)position;
+	position += m_nb_edges * sizeof(Node_Id);
+	m_strings = position;
+
+	// @Warning only the ends of adjacency arrays are checked, checking every offset would read the whole file
+	if (m_child_offsets[m_nb_nodes] != m_nb_edges || m_parent_offsets[m_nb_nodes] != m_nb_edges) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+std::string_view Graph_Snapshot::string(uint32_t offset, uint32_t length) const
+{
+	if ((size_t)offset + length > m_strings_size) {
+		return std::string_view();	// A corrupted node
+	}
+	return std::string_view(m_strings + offset, length);
+}
+
+std::string_view Graph_Snapshot::label(Node_Id node) const
+{
+	return string(m_nodes[node].label_offset, m_nodes[node].label_length);
+}
+
+std::string_view Graph_Snapshot::path(Node_Id node) const
+{
+	return string(m_nodes[node].path_offset, m_nodes[node].path_length);
+}
+
+Node_Attributes Graph_Snapshot::attributes(Node_Id node) const
+{
+	Node_Attributes	attributes;
+
+	attributes.nb_lines = m_nodes[node].nb_lines;
+	attributes.file_type = (File_Type)m_nodes[node].file_type;
+	attributes.file_found = m_nodes[node].file_found != 0;
+	return attributes;
+}
+
+size_t Graph_Snapshot::nb_inclusions(Node_Id node) const
+{
+	return m_nodes[node].nb_inclusions;
+}
+
+bool Graph_Snapshot::save(const fs::path& file_path, const File_Graph& graph, const std::vector<Node_Texts>& texts, const std::vector<Node_Id>& root_nodes)
+{
+	Header											header;
+	std::vector<Node>								nodes(graph.nb_nodes());
+	std::vector<uint32_t>							child_offsets;
+	std::vector<Node_Id>							children;
+	std::vector<uint32_t>							parent_offsets;
+	std::vector<Node_Id>							parents;
+	std::string										strings;
+	std::unordered_map<std::string_view, uint32_t>	string_offsets;	// Paths shared by nodes are written once
+
+	auto add_string = [&](std::string_view text) {
+		auto	it = string_offsets.try_emplace(text, (uint32_t)strings.size());
+
+		if (it.second) {
+			strings += text;
+		}
+		return it.first->second;
+	};
+
+	child_offsets.reserve(graph.nb_nodes() + 1);
+	parent_offsets.reserve(graph.nb_nodes() + 1);
+	children.reserve(graph.nb_edges());
+	parents.reserve(graph.nb_edges());
+	for (Node_Id node = 0; node < (Node_Id)graph.nb_nodes(); node++)
+	{
+		const Node_Attributes&	attributes = graph.attributes(node);
+		Node&					snapshot_node = nodes[node];
+
+		snapshot_node.label_offset = add_string(texts[node].label);
+		snapshot_node.label_length = (uint32_t)texts[node].label.length();
+		snapshot_node.path_offset = add_string(texts[node].path);
+		snapshot_node.path_length = (uint32_t)texts[node].path.length();
+		snapshot_node.nb_lines = attributes.nb_lines;
+		snapshot_node.nb_inclusions = (uint32_t)graph.nb_inclusions(node);
+		snapshot_node.file_type = (uint8_t)attributes.file_type;
+		snapshot_node.file_found = attributes.file_found ? 1 : 0;
+		snapshot_node.padding[0] = 0;
+		snapshot_node.padding[1] = 0;
+
+		child_offsets.push_back((uint32_t)children.size());
+		children.insert(children.end(), graph.children(node).begin(), graph.children(node).end());
+		parent_offsets.push_back((uint32_t)parents.size());
+		parents.insert(parents.end(), graph.parents(node).begin(), graph.parents(node).end());
+	}
+	child_offsets.push_back((uint32_t)children.size());
+	parent_offsets.push_back((uint32_t)parents.size());
+
+	if (strings.size() > UINT32_MAX) {
+		return false;	// Offsets of texts are 32 bits
+	}
+
+	memcpy(header.magic, graph_snapshot_magic, sizeof(graph_snapshot_magic));
+	header.version = graph_snapshot_version;
+	header.nb_nodes = (uint32_t)nodes.size();
+	header.nb_edges = (uint32_t)children.size();
+	header.nb_root_nodes = (uint32_t)root_nodes.size();
+	header.strings_size = strings.size();
+
+	fs::path		temporary_path = file_path;
+	std::ofstream	file;
+
+	temporary_path += ".tmp";
+	file.open(temporary_path, std::fstream::out | std::fstream::binary | std::fstream::trunc);
+	if (file.is_open() == false) {
+		return false;
+	}
+	file.write((const char*)&header, sizeof(Header));
+	file.write((const char*)nodes.data(), nodes.size() * sizeof(Node));
+	file.write((const char*)root_nodes.data(), root_nodes.size() * sizeof(Node_Id));
+	file.write((const char*)child_offsets.data(), child_offsets.size() * sizeof(uint32_t));
+	file.write((const char*)children.data(), children.size() * sizeof(Node_Id));
+	file.write((const char*)parent_offsets.data(), parent_offsets.size() * sizeof(uint32_t));
+	file.write((const char*)parents.data(), parents.size() * sizeof(Node_Id));
+	file.write(strings.data(), strings.size());
+	file.close();
+	if (file.fail()) {
+		return false;
+	}
+
+	std::error_code	error;
+
+	fs::rename(temporary_path, file_path, error);
+	return !error;
+}
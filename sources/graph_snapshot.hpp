@@ -0,0 +1,70 @@
+#pragma once
+
+#include "file_graph.hpp"
+#include "utilities.hpp"
+
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+/// Include graph of a project saved at the end of a run, for analyses and queries that don't scan sources again
+/// The file is the frozen graph as it is in memory: a node table, root nodes, children and parents in compressed sparse
+/// row arrays, then paths (each one once)
+/// Loading maps the file and checks its header, nothing is parsed nor copied, pages are read when they are touched
+/// @Warning in the byte order of the machine, like scan cache files
+class Graph_Snapshot
+{
+public:
+	Graph_Snapshot() = default;
+	Graph_Snapshot(const Graph_Snapshot&) = delete;
+
+	Graph_Snapshot&		operator=(const Graph_Snapshot&) = delete;
+
+	/// Return false if there is no valid snapshot at this path (another version, or a truncated file)
+	bool				load(const std::filesystem::path& file_path);
+	void				close();
+
+	size_t				nb_nodes() const { return m_nb_nodes; }
+	size_t				nb_edges() const { return m_nb_edges; }
+
+	/// Sources of source folders, in the order of the run
+	Node_Range			root_nodes() const { return Node_Range(m_root_nodes, m_root_nodes + m_nb_root_nodes); }
+
+	std::string_view	label(Node_Id node) const;
+	std::string_view	path(Node_Id node) const;
+	Node_Attributes		attributes(Node_Id node) const;
+	size_t				nb_inclusions(Node_Id node) const;
+
+	Node_Range			children(Node_Id node) const { return Node_Range(m_children + m_child_offsets[node], m_children + m_child_offsets[node + 1]); }
+	Node_Range			parents(Node_Id node) const { return Node_Range(m_parents + m_parent_offsets[node], m_parents + m_parent_offsets[node + 1]); }
+
+	/// Append nodes from which one of the given nodes is reachable (they are included), see find_ancestors
+	void				ancestors(const std::vector<Node_Id>& nodes, std::vector<Node_Id>& reached) const { find_ancestors(*this, nodes, reached); }
+
+	/// Write the graph in a temporary file that replaces the previous snapshot once complete (a mapped snapshot stays
+	/// valid on systems that allow it), texts are by node
+	/// @Warning the graph has to be frozen
+	static bool			save(const std::filesystem::path& file_path, const File_Graph& graph, const std::vector<Node_Texts>& texts, const std::vector<Node_Id>& root_nodes);
+
+private:
+	struct Header;
+	struct Node;
+
+	/// Size of the file without texts
+	static uint64_t		sections_size(uint64_t nb_nodes, uint64_t nb_edges, uint64_t nb_root_nodes);
+
+	std::string_view	string(uint32_t offset, uint32_t length) const;
+
+	File_View			m_file;
+	const Node*			m_nodes = nullptr;
+	size_t				m_nb_nodes = 0;
+	size_t				m_nb_edges = 0;
+	const Node_Id*		m_root_nodes = nullptr;
+	size_t				m_nb_root_nodes = 0;
+	const uint32_t*		m_child_offsets = nullptr;	// nb_nodes + 1 offsets in m_children
+	const Node_Id*		m_children = nullptr;
+	const uint32_t*		m_parent_offsets = nullptr;	// nb_nodes + 1 offsets in m_parents
+	const Node_Id*		m_parents = nullptr;
+	const char*			m_strings = nullptr;
+	size_t				m_strings_size = 0;
+};
@@ -1,52 +1,87 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <initializer_list>
 #include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 
-#include <cassert>
+#include <stdint.h>
 
 /// !!! Warning the Key type have to be unsigned fundamental type
 /// A pure hash table
-/// It contains only an array that take the size necessary to contains all possible
-/// values of Key type
+/// It is a two level table: the high bits of the key select a page in a directory, and the low bits
+/// the value in the page. Only nb_pages pages are stored, all other directory entries share one page
+/// filled with the default value, so a sparse table of 16 bits keys costs a few KB instead of 64K values.
+/// By default all pages are stored (a flat table of all possible values of the Key type).
+///
+/// The constructor is constexpr, a static constexpr table is built by the compiler (no initialization at startup).
+/// !!! Warning if values need more than nb_pages pages or conflict, the constructor throws (a compilation error for a constexpr table)
 
 // TODO
 // Restrict by the Key types (unsigned int,...)
-//
-// Take a look if it is possible to fragment the table in multiple with a very simple
-// division mecanisme, this will allow to have only used table allocated
-template<typename Hash_Type, typename Value_Type, Value_Type default_value = Value_Type()>
+template<typename Hash_Type, typename Value_Type, Value_Type default_value = Value_Type(),
+    size_t nb_pages = ((size_t)std::numeric_limits<Hash_Type>::max() >> std::min<size_t>(std::numeric_limits<Hash_Type>::digits, 8)) + 1>
 class Hash_Table
 {
-    static const size_t   max_nb_values = std::numeric_limits<Hash_Type>::max() + 1;
+    static constexpr size_t     max_nb_values = (size_t)std::numeric_limits<Hash_Type>::max() + 1;
+    static constexpr size_t     page_bits = std::min<size_t>(std::numeric_limits<Hash_Type>::digits, 8);
+    static constexpr size_t     page_size = (size_t)1 << page_bits;
+    static constexpr size_t     directory_size = max_nb_values / page_size;
+    static constexpr bool       has_default_page = nb_pages < directory_size;
+    static constexpr size_t     nb_stored_pages = nb_pages + (has_default_page ? 1 : 0);   // @Warning the default page is the last one
 
-public:
-    struct Hash_Pair
-    {
-        Hash_Type    hash;
-        Value_Type   value;
-    };
+    static_assert(nb_pages <= directory_size, "More pages than possible values");
+
+    using Page_Index = std::conditional_t<(nb_stored_pages <= 256), uint8_t, uint16_t>;
+    using Page = std::array<Value_Type, page_size>;
 
-    Hash_Table()
+public:
+    constexpr Hash_Table()
     {
-        for (size_t i = 0; i < max_nb_values; i++)
-            m_table[i] = default_value;
+        for (Page& page : m_pages)
+            for (Value_Type& value : page)
+                value = default_value;
+        for (size_t i = 0; i < directory_size; i++)
+            m_directory[i] = (Page_Index)(has_default_page ? nb_pages : i);
     }
 
-    Hash_Table(std::initializer_list<std::pair<Hash_Type, Value_Type>> values)
+    constexpr Hash_Table(std::initializer_list<std::pair<Hash_Type, Value_Type>> values)
+        : Hash_Table()
     {
-        for (size_t i = 0; i < max_nb_values; i++)
-            m_table[i] = default_value;
+        size_t  nb_used_pages = 0;
+
         for (auto& value_pair : values)
         {
-            assert(m_table[value_pair.first] == default_value);  // check against conflict
-            m_table[value_pair.first] = value_pair.second;
+            size_t  directory_index = (size_t)value_pair.first >> page_bits;
+
+            // @Warning without a default page each directory entry already has its own page, and nb_pages can't be stored in a Page_Index
+            if (has_default_page && m_directory[directory_index] == (Page_Index)nb_pages)
+            {
+                if (nb_used_pages == nb_pages)
+                    throw std::logic_error("Not enough pages in the Hash_Table");
+                m_directory[directory_index] = (Page_Index)nb_used_pages++;
+            }
+
+            Value_Type& value = m_pages[m_directory[directory_index]][(size_t)value_pair.first & (page_size - 1)];
+
+            if (value != default_value)
+                throw std::logic_error("Conflict in the Hash_Table");   // check against conflict
+            value = value_pair.second;
         }
     }
 
-    Value_Type& operator[](const Hash_Type& hash) { return m_table[hash]; }
+    constexpr Value_Type operator[](const Hash_Type& hash) const
+    {
+        return m_pages[m_directory[(size_t)hash >> page_bits]][(size_t)hash & (page_size - 1)];
+    }
 
+    /// Return the number of bytes of the table
+    static constexpr size_t memory_usage() { return sizeof(m_directory) + sizeof(m_pages); }
 
 private:
-    std::array<Value_Type, max_nb_values>   m_table;
+    std::array<Page_Index, directory_size>  m_directory = {};
+    std::array<Page, nb_stored_pages>       m_pages = {};
 };
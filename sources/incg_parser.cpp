@@ -50,7 +50,7 @@ namespace incg
 		return state == State::comment_line;
 	}
 
-	bool incg::parse_configuration(const std::vector<Token>& tokens, Configuration& result)
+	bool parse_configuration(const Token_Stream& tokens, Configuration& result)
 	{
 		std::stack<State>				states;
 		Token							name_token;
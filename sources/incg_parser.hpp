@@ -23,5 +23,5 @@ namespace incg
 		std::string				__string_views_buffer;	// @Warning private field
 	};
 
-	bool parse_configuration(const std::vector<Token>& tokens, Configuration& result);
+	bool parse_configuration(const Token_Stream& tokens, Configuration& result);
 }
@@ -1,7 +1,12 @@
 #pragma once
 
+#include "hash_table.hpp"
 #include "incg_language_definitions.hpp"
+#include "keyword_table.hpp"
+#include "token_stream.hpp"
+#include "tokenizer.hpp"
 
+#include <string>
 #include <vector>
 #include <string_view>
 
@@ -25,5 +30,57 @@ namespace incg
 		return lhs.text == rhs.text;
 	}
 
-	void    tokenize(const std::string& text, std::vector<Token>& tokens);
+	using Token_Stream = Packed_Token_Stream<Token>;
+
+	/// Traits of the configuration language for the Tokenizer
+	struct Language_Definition
+	{
+		using Token = incg::Token;
+		using Punctuation = incg::Punctuation;
+		using Keyword = incg::Keyword;
+
+		static constexpr Punctuation	first_single_character_punctuation = Punctuation::hash;
+
+		static constexpr Hash_Table<uint16_t, Punctuation, Punctuation::unknown, 0> punctuation_table_2 = {
+		};
+
+		static constexpr Hash_Table<uint8_t, Punctuation, Punctuation::unknown> punctuation_table_1 = {
+			// White characters (aren't handle for an implicit skip/separation between tokens)
+			{' ', Punctuation::white_character},       // space
+			{'\t', Punctuation::white_character},      // horizontal tab
+			{'\v', Punctuation::white_character},      // vertical tab
+			{'\f', Punctuation::white_character},      // feed
+			{'\r', Punctuation::white_character},      // carriage return
+			{'\n', Punctuation::new_line_character},   // newline
+			{'#', Punctuation::hash},
+			{'{', Punctuation::open_brace},
+			{'}', Punctuation::close_brace},
+			{'[', Punctuation::open_bracket},
+			{']', Punctuation::close_bracket},
+			{':', Punctuation::colon},
+			{'"', Punctuation::double_quote},
+			{',', Punctuation::comma},
+		};
+
+		static constexpr auto	keywords = make_keyword_table<Keyword>({
+			{std::string_view("Project"),				Keyword::project},
+			{std::string_view("name"),					Keyword::name},
+			{std::string_view("output_folder"),			Keyword::output_folder},
+			{std::string_view("sources_folders"),		Keyword::sources_folders},
+			{std::string_view("include_directories"),	Keyword::include_directories},
+		});
+
+		static bool	is_white_punctuation(Punctuation punctuation) { return incg::is_white_punctuation(punctuation); }
+
+		class Keyword_Classifier
+		{
+		public:
+			Keyword	classify(const Token& token) const
+			{
+				return token.punctuation == Punctuation::unknown ? keywords.find(token.text) : Keyword::unknown;
+			}
+		};
+	};
+
+	void    tokenize(const std::string& text, Token_Stream& tokens);
 }
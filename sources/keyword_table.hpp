@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <stdexcept>
+#include <string_view>
+
+#include <stdint.h>
+
+template<typename Keyword_Type>
+struct Keyword_Entry
+{
+	std::string_view	text;
+	Keyword_Type		keyword = Keyword_Type();
+};
+
+/// A perfect hash table of keywords generated at compile time
+/// The hash only reads the length, the first, middle and last characters of the text; the constructor
+/// searches a seed that gives no collision between keywords, so a lookup is one hash and one comparison
+/// Texts with a length that no keyword have are rejected without hashing
+///
+/// !!! Warning Keyword_Type() have to be the value of unknown keywords
+/// !!! Warning if no seed is found (keywords sharing their length, first, middle and last characters)
+/// the constructor throws, which is a compilation error for a constexpr table
+template<typename Keyword_Type, size_t nb_keywords>
+class Keyword_Table
+{
+	static constexpr size_t next_power_of_2(size_t value)
+	{
+		size_t	result = 1;
+
+		while (result < value)
+			result *= 2;
+		return result;
+	}
+
+	static constexpr size_t		table_size = next_power_of_2(nb_keywords * 2);	// Half empty to find a seed quickly
+	static constexpr uint32_t	max_seed = 1 << 16;
+
+public:
+	constexpr Keyword_Table(const Keyword_Entry<Keyword_Type> (&keywords)[nb_keywords])
+	{
+		for (const Keyword_Entry<Keyword_Type>& keyword : keywords)
+		{
+			if (keyword.text.empty())
+				throw std::logic_error("Keywords can't be empty");
+			m_min_length = keyword.text.length() < m_min_length ? keyword.text.length() : m_min_length;
+			m_max_length = keyword.text.length() > m_max_length ? keyword.text.length() : m_max_length;
+		}
+
+		for (m_seed = 1; m_seed < max_seed; m_seed++)
+		{
+			if (try_seed(keywords))
+				return;
+		}
+		throw std::logic_error("No perfect hash found for those keywords");
+	}
+
+	constexpr Keyword_Type	find(std::string_view text) const
+	{
+		if (text.length() < m_min_length || text.length() > m_max_length)
+			return Keyword_Type();
+
+		const Keyword_Entry<Keyword_Type>&	slot = m_slots[index(text, m_seed)];
+
+		return slot.text == text ? slot.keyword : Keyword_Type();
+	}
+
+private:
+	static constexpr size_t	index(std::string_view text, uint32_t seed)
+	{
+		uint32_t	hash = (uint32_t)text.length();
+
+		hash = hash * seed + (uint8_t)text[0];
+		hash = hash * seed + (uint8_t)text[text.length() / 2];
+		hash = hash * seed + (uint8_t)text[text.length() - 1];
+		return (hash ^ (hash >> 16)) & (table_size - 1);
+	}
+
+	constexpr bool	try_seed(const Keyword_Entry<Keyword_Type> (&keywords)[nb_keywords])
+	{
+		for (Keyword_Entry<Keyword_Type>& slot : m_slots)
+			slot = Keyword_Entry<Keyword_Type>();
+
+		for (const Keyword_Entry<Keyword_Type>& keyword : keywords)
+		{
+			Keyword_Entry<Keyword_Type>&	slot = m_slots[index(keyword.text, m_seed)];
+
+			if (slot.text.empty() == false)
+				return false;
+			slot = keyword;
+		}
+		return true;
+	}
+
+	std::array<Keyword_Entry<Keyword_Type>, table_size>	m_slots = {};
+	size_t												m_min_length = (size_t)-1;
+	size_t												m_max_length = 0;
+	uint32_t											m_seed = 0;
+};
+
+/// Deduce the number of keywords: static constexpr auto keywords = make_keyword_table<Keyword>({{"if"sv, Keyword::_if}, ...});
+template<typename Keyword_Type, size_t nb_keywords>
+constexpr Keyword_Table<Keyword_Type, nb_keywords>	make_keyword_table(const Keyword_Entry<Keyword_Type> (&keywords)[nb_keywords])
+{
+	return Keyword_Table<Keyword_Type, nb_keywords>(keywords);
+}
@@ -14,17 +14,6 @@
 
 namespace macro
 {
-	enum class State
-	{
-		global_scope,
-		comment_line,
-		comment_block,
-		macro_expression,
-		include_directive,
-
-		eof
-	};
-
 	static std::string state_names[] = {
 		"global_scope",
 		"comment_line",
@@ -35,128 +24,142 @@ namespace macro
 		"eof"
 	};
 
-	static bool	is_one_line_state(State state)
+	// @Warning used for debug purpose
+	static const size_t	print_start = 0;
+	static const size_t	print_end = 0;
+
+	Macro_Parser::Macro_Parser(Include_Callback on_include)
+		: m_on_include(std::move(on_include))
+	{
+		m_states.push(State::global_scope);
+	}
+
+	bool Macro_Parser::is_one_line_state(State state)
 	{
 		return state == State::macro_expression	// Actually we don't manage every macro directive (we stay on this state)
+			|| state == State::include_directive	// @Warning #include MACRO_HEADER have no path
 			|| state == State::comment_line;
 	}
 
-	void macro::parse_macros(const std::vector<Token>& tokens, Macro_Parsing_Result& result)
+	void Macro_Parser::parse(const Token& token)
 	{
-		std::stack<State>	states;
-		Token				name_token;
-		size_t				previous_line = 0;
-		std::string_view    string_litteral;
-		bool				in_string_literal = false;
-		bool				start_new_line = true;
-		const char*			string_views_buffer = nullptr;	// @Warning all string views are about this string_views_buffer
-
-		// Those stacks should have the same size
-		// As stack to handle members and methods
-
-		// @Warning used for debug purpose
-		size_t  print_start = 0;
-		size_t  print_end = 0;
+		State	state = m_states.top();
+		bool	start_new_line = token.line > m_previous_line
+			&& m_previous_punctuation != Punctuation::backslash;	// @Warning a backslash at the end of the line continues it
 
-		states.push(State::global_scope);
+		// Handle here states that have to be poped on new line detection
+		if (start_new_line
+			&& is_one_line_state(state))
+		{
+			m_states.pop();
+			state = m_states.top();
+		}
 
-		if (tokens.size()) {
-			string_views_buffer = tokens[0].text.data();	// @Warning all string views are about this string_views_buffer
+		if (token.line >= print_start && token.line < print_end) {
+			std::cout
+				<< std::string(m_states.size() - 1, ' ') << state_names[(size_t)state]
+				<< " " << token.line << " " << token.column << " " << token.text << std::endl;
 		}
 
-		for (const Token& token : tokens)
+		if (state == State::comment_block)
 		{
-			State& state = states.top();
-
-			if (token.line > previous_line) {
-				start_new_line = true;
-			}
-
-			// Handle here states that have to be poped on new line detection
-			if (start_new_line
-				&& is_one_line_state(state))
-			{
-				states.pop();
-				state = states.top();
-			}
-
-			if (token.line >= print_start && token.line < print_end) {
-				std::cout
-					<< std::string(states.size() - 1, ' ') << state_names[(size_t)state]
-					<< " " << token.line << " " << token.column << " " << token.text << std::endl;
-			}
-
-			if (state == State::comment_block)
+			if (token.punctuation == Punctuation::close_block_comment)
+				m_states.pop();
+		}
+		else if (state == State::macro_expression)
+		{
+			if (token.keyword == Keyword::_include
+				&& m_previous_punctuation == Punctuation::hash)	// @Warning only the directive name (not "#if 0 /* include */")
 			{
-				if (token.punctuation == Punctuation::close_block_comment)
-					states.pop();
+				m_states.pop();
+				m_states.push(State::include_directive);
+				m_in_string_literal = false;
 			}
-			else if (state == State::macro_expression)
-			{
-				if (token.keyword == Keyword::_include)
-				{
-					states.pop();
-					states.push(State::include_directive);
-				}
+			else if (token.punctuation == Punctuation::open_block_comment) {
+				m_states.push(State::comment_block);
 			}
-			else if (state == State::include_directive)
+		}
+		else if (state == State::include_directive)
+		{
+			if (token.punctuation == Punctuation::double_quote
+				|| token.punctuation == Punctuation::less
+				|| token.punctuation == Punctuation::greater)
 			{
-				if (token.punctuation == Punctuation::double_quote
-					|| token.punctuation == Punctuation::less
-					|| token.punctuation == Punctuation::greater)
+				if (m_in_string_literal)
 				{
-					if (in_string_literal)
-					{
-						Include	include;
+					Include	include;
 
-						include.type = (token.punctuation == Punctuation::greater) ? Include_Type::external : Include_Type::local;
-						include.path = string_litteral;
-						result.includes.push_back(include);
+					include.type = (token.punctuation == Punctuation::greater) ? Include_Type::external : Include_Type::local;
+					include.path = m_string_litteral;
+					m_on_include(include);
 
-						in_string_literal = false;
-						states.pop();
-					}
-					else
-					{
-						in_string_literal = true;
-						string_litteral = std::string_view();
-					}
+					m_in_string_literal = false;
+					m_states.pop();
 				}
-				else if (token.keyword == Keyword::_unknown
-					&& token.punctuation == Punctuation::unknown)
+				else
 				{
-					// Building the string litteral (can be splitted into multiple tokens)
-					if (in_string_literal)
-					{
-						if (string_litteral.length() == 0)
-							string_litteral = token.text;
-						else
-							string_litteral = std::string_view(
-								string_litteral.data(),
-								(token.text.data() + token.text.length()) - string_litteral.data());    // Can't simply add length of string_litteral and token.text because white space tokens are skipped
-					}
+					m_in_string_literal = true;
+					m_string_litteral = std::string_view();
 				}
 			}
-			else if (state == State::global_scope)
+			else if (token.keyword == Keyword::_unknown
+				&& token.punctuation == Punctuation::unknown)
 			{
-				if (start_new_line	// @Warning to be sure that we are on the beginning of the line
-					&& token.punctuation == Punctuation::hash) {   // Macro
-					states.push(State::macro_expression);
-				}
-				else if (token.punctuation == Punctuation::open_block_comment) {
-					states.push(State::comment_block);
-				}
-				else if (token.punctuation == Punctuation::line_comment) {
-					states.push(State::comment_line);
+				// Building the string litteral (can be splitted into multiple tokens)
+				if (m_in_string_literal)
+				{
+					if (m_string_litteral.length() == 0)
+						m_string_litteral = token.text;
+					else
+						m_string_litteral = std::string_view(
+							m_string_litteral.data(),
+							(token.text.data() + token.text.length()) - m_string_litteral.data());    // Can't simply add length of m_string_litteral and token.text because white space tokens are skipped
 				}
 			}
-			start_new_line = false;
-			previous_line = token.line;
 		}
+		else if (state == State::global_scope)
+		{
+			if (start_new_line	// @Warning to be sure that we are on the beginning of the line
+				&& token.punctuation == Punctuation::hash) {   // Macro
+				m_states.push(State::macro_expression);
+			}
+			else if (token.punctuation == Punctuation::open_block_comment) {
+				m_states.push(State::comment_block);
+			}
+			else if (token.punctuation == Punctuation::line_comment) {
+				m_states.push(State::comment_line);
+			}
+		}
+		m_previous_line = token.line;
+		m_previous_punctuation = token.punctuation;
+	}
 
+	void Macro_Parser::finish()
+	{
 		// @Warning we should finish on the global_scope state or one that can stay active only on one line
-		assert(states.size() >= 1 && states.size() <= 2);
-		assert(states.top() == State::global_scope
-			|| is_one_line_state(states.top()));
+		assert(m_states.size() >= 1 && m_states.size() <= 2);
+		assert(m_states.top() == State::global_scope
+			|| is_one_line_state(m_states.top()));
+	}
+
+	void parse_macros(const Token_Stream& tokens, Macro_Parsing_Result& result)
+	{
+		Macro_Parser	parser([&result](const Include& include) { result.includes.push_back(include); });
+
+		for (const Token& token : tokens) {
+			parser.parse(token);
+		}
+		parser.finish();
+	}
+
+	void parse_macros(Lexer& lexer, const Include_Callback& on_include)
+	{
+		Macro_Parser	parser(on_include);
+		Token			token;
+
+		while (lexer.next(token)) {
+			parser.parse(token);
+		}
+		parser.finish();
 	}
 }
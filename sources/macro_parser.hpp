@@ -2,6 +2,8 @@
 
 #include "macro_tokenizer.hpp"
 
+#include <functional>
+#include <stack>
 #include <vector>
 #include <string_view>
 
@@ -24,5 +26,43 @@ namespace macro
 		std::vector<Include>	includes;
 	};
 
-	void parse_macros(const std::vector<Token>& tokens, Macro_Parsing_Result& result);
+	using Include_Callback = std::function<void(const Include& include)>;
+
+	/// State machine of the macro language, it consumes tokens one by one
+	/// Includes are given to the callback as soon as their closing '"' or '>' is parsed
+	class Macro_Parser
+	{
+	public:
+		Macro_Parser(Include_Callback on_include);
+
+		void	parse(const Token& token);
+		/// Check that the parser ends in a valid state
+		void	finish();
+
+	private:
+		enum class State
+		{
+			global_scope,
+			comment_line,
+			comment_block,
+			macro_expression,
+			include_directive,
+
+			eof
+		};
+
+		static bool	is_one_line_state(State state);
+
+		Include_Callback	m_on_include;
+		std::stack<State>	m_states;
+		size_t				m_previous_line = 0;
+		Punctuation			m_previous_punctuation = Punctuation::unknown;
+		std::string_view	m_string_litteral;
+		bool				m_in_string_literal = false;
+	};
+
+	void parse_macros(const Token_Stream& tokens, Macro_Parsing_Result& result);
+
+	/// Fused tokenization and parsing: tokens are pulled from the lexer one by one (they are never stored)
+	void parse_macros(Lexer& lexer, const Include_Callback& on_include);
 }
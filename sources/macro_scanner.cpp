@@ -0,0 +1,217 @@
+#include "macro_scanner.hpp"
+
+#include <array>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#	define SCANNER_X86
+#	include <immintrin.h>
+#endif
+
+#if defined(SCANNER_X86) && !defined(_MSC_VER)
+#	define SCANNER_TARGET_SSE2	__attribute__((target("sse2")))
+#	define SCANNER_TARGET_AVX2	__attribute__((target("avx2")))
+#else
+#	define SCANNER_TARGET_SSE2
+#	define SCANNER_TARGET_AVX2
+#endif
+
+using namespace macro;
+
+static constexpr std::array<bool, 256> make_special_characters_table()
+{
+	std::array<bool, 256>	table = {};
+
+	table['\n'] = true;
+	table['#'] = true;
+	table['/'] = true;
+	table['"'] = true;
+	table['\''] = true;
+	table['\\'] = true;
+	return table;
+}
+
+static constexpr std::array<bool, 256>	special_characters = make_special_characters_table();
+
+static uint64_t scan_block_scalar(const char* block)
+{
+	uint64_t	mask = 0;
+
+	for (size_t i = 0; i < scanner_block_size; i++) {
+		mask |= (uint64_t)special_characters[(uint8_t)block[i]] << i;
+	}
+	return mask;
+}
+
+#if defined(SCANNER_X86)
+
+SCANNER_TARGET_SSE2 static uint64_t scan_block_sse2(const char* block)
+{
+	const __m128i	new_line = _mm_set1_epi8('\n');
+	const __m128i	hash = _mm_set1_epi8('#');
+	const __m128i	slash = _mm_set1_epi8('/');
+	const __m128i	double_quote = _mm_set1_epi8('"');
+	const __m128i	single_quote = _mm_set1_epi8('\'');
+	const __m128i	backslash = _mm_set1_epi8('\\');
+	uint64_t		mask = 0;
+
+	for (size_t i = 0; i < scanner_block_size; i += 16)
+	{
+		__m128i	chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+		__m128i	matches = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(chunk, new_line), _mm_cmpeq_epi8(chunk, hash)),
+			_mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(chunk, slash), _mm_cmpeq_epi8(chunk, double_quote)),
+				_mm_or_si128(_mm_cmpeq_epi8(chunk, single_quote), _mm_cmpeq_epi8(chunk, backslash))));
+
+		mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(matches) << i;
+	}
+	return mask;
+}
+
+SCANNER_TARGET_AVX2 static uint64_t scan_block_avx2(const char* block)
+{
+	const __m256i	new_line = _mm256_set1_epi8('\n');
+	const __m256i	hash = _mm256_set1_epi8('#');
+	const __m256i	slash = _mm256_set1_epi8('/');
+	const __m256i	double_quote = _mm256_set1_epi8('"');
+	const __m256i	single_quote = _mm256_set1_epi8('\'');
+	const __m256i	backslash = _mm256_set1_epi8('\\');
+	uint64_t		mask = 0;
+
+	for (size_t i = 0; i < scanner_block_size; i += 32)
+	{
+		__m256i	chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+		__m256i	matches = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(chunk, new_line), _mm256_cmpeq_epi8(chunk, hash)),
+			_mm256_or_si256(
+				_mm256_or_si256(_mm256_cmpeq_epi8(chunk, slash), _mm256_cmpeq_epi8(chunk, double_quote)),
+				_mm256_or_si256(_mm256_cmpeq_epi8(chunk, single_quote), _mm256_cmpeq_epi8(chunk, backslash))));
+
+		mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(matches) << i;
+	}
+	return mask;
+}
+
+static bool cpu_supports_sse2()
+{
+#if defined(_M_X64) || defined(__x86_64__)
+	return true;	// Part of the x86-64 base instruction set
+#elif defined(_MSC_VER)
+	int	registers[4];
+
+	__cpuid(registers, 1);
+	return (registers[3] & (1 << 26)) != 0;
+#else
+	return __builtin_cpu_supports("sse2");
+#endif
+}
+
+static bool cpu_supports_avx2()
+{
+#if defined(_MSC_VER)
+	int	registers[4];
+
+	__cpuid(registers, 0);
+	if (registers[0] < 7) {
+		return false;
+	}
+
+	__cpuid(registers, 1);
+	bool	os_saves_avx_registers = (registers[2] & (1 << 27)) != 0	// OSXSAVE
+		&& (_xgetbv(0) & 0x6) == 0x6;								// XMM and YMM states are enabled
+	if (os_saves_avx_registers == false) {
+		return false;
+	}
+
+	__cpuidex(registers, 7, 0);
+	return (registers[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+using Scan_Block_Function = uint64_t(*)(const char* block);
+
+static Scan_Block_Function get_scan_block_function(Scanner_Implementation implementation)
+{
+	switch (implementation)
+	{
+#if defined(SCANNER_X86)
+	case Scanner_Implementation::sse2:
+		return &scan_block_sse2;
+	case Scanner_Implementation::avx2:
+		return &scan_block_avx2;
+#endif
+	default:
+		return &scan_block_scalar;
+	}
+}
+
+static Scanner_Implementation	current_implementation = best_scanner_implementation();
+static Scan_Block_Function		scan_block_function = get_scan_block_function(current_implementation);
+
+bool macro::is_scanner_implementation_supported(Scanner_Implementation implementation)
+{
+	switch (implementation)
+	{
+	case Scanner_Implementation::scalar:
+		return true;
+#if defined(SCANNER_X86)
+	case Scanner_Implementation::sse2:
+	{
+		static const bool	supported = cpu_supports_sse2();
+		return supported;
+	}
+	case Scanner_Implementation::avx2:
+	{
+		static const bool	supported = cpu_supports_avx2();
+		return supported;
+	}
+#endif
+	default:
+		return false;
+	}
+}
+
+Scanner_Implementation macro::best_scanner_implementation()
+{
+	if (is_scanner_implementation_supported(Scanner_Implementation::avx2)) {
+		return Scanner_Implementation::avx2;
+	}
+	if (is_scanner_implementation_supported(Scanner_Implementation::sse2)) {
+		return Scanner_Implementation::sse2;
+	}
+	return Scanner_Implementation::scalar;
+}
+
+bool macro::set_scanner_implementation(Scanner_Implementation implementation)
+{
+	if (is_scanner_implementation_supported(implementation) == false) {
+		return false;
+	}
+
+	current_implementation = implementation;
+	scan_block_function = get_scan_block_function(implementation);
+	return true;
+}
+
+Scanner_Implementation macro::get_scanner_implementation()
+{
+	return current_implementation;
+}
+
+uint64_t macro::scan_block(const char* block)
+{
+	return scan_block_function(block);
+}
+
+uint64_t macro::scan_tail(const char* block, size_t length)
+{
+	char	padded_block[scanner_block_size] = {};	// @Warning '\0' isn't a special character
+
+	std::memcpy(padded_block, block, length < scanner_block_size ? length : scanner_block_size);
+	return scan_block_function(padded_block);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(_MSC_VER)
+#	include <intrin.h>
+#endif
+
+/*
+	Vectorized scanner used by the directives fast path of the macro tokenizer.
+	It finds positions of characters that can change the state of the preprocessor lexer
+	(new lines, '#', comments, string and char literals, escapes) in blocks of 64 bytes.
+	Everything else (identifiers, operators,...) is skipped without being looked at.
+*/
+namespace macro
+{
+	enum class Scanner_Implementation : uint8_t
+	{
+		scalar,
+		sse2,
+		avx2
+	};
+
+	static const size_t	scanner_block_size = 64;
+
+	/// Return the fastest implementation supported by the CPU (detected once at runtime)
+	Scanner_Implementation	best_scanner_implementation();
+	bool					is_scanner_implementation_supported(Scanner_Implementation implementation);
+
+	/// The tokenizer uses the best implementation by default, this can be forced for tests and benchmarks
+	/// Return false if the implementation isn't supported by the CPU (the current one is kept)
+	bool					set_scanner_implementation(Scanner_Implementation implementation);
+	Scanner_Implementation	get_scanner_implementation();
+
+	/// Return a mask where the bit i is set if block[i] is one of: '\n' '#' '/' '"' '\'' '\\'
+	/// @Warning block have to be readable for scanner_block_size bytes, use scan_tail for the end of a buffer
+	uint64_t	scan_block(const char* block);
+	uint64_t	scan_tail(const char* block, size_t length);
+
+	inline unsigned	count_trailing_zeros(uint64_t mask)
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long	index;
+
+		_BitScanForward64(&index, mask);
+		return (unsigned)index;
+#elif defined(_MSC_VER)
+		unsigned long	index;
+
+		if (_BitScanForward(&index, (unsigned long)mask)) {
+			return (unsigned)index;
+		}
+		_BitScanForward(&index, (unsigned long)(mask >> 32));
+		return (unsigned)index + 32;
+#else
+		return (unsigned)__builtin_ctzll(mask);
+#endif
+	}
+}
@@ -1,8 +1,6 @@
 #include "macro_tokenizer.hpp"
 
-#include "hash_table.hpp"
-
-#include <unordered_map>
+#include "macro_scanner.hpp"
 
 using namespace std::literals;	// For string literal suffix (conversion to std::string_view)
 
@@ -10,191 +8,272 @@ using namespace macro;
 
 static const std::size_t    tokens_length_heuristic = 6;
 
-/// Return a key for the punctuation of 2 characters
-constexpr static std::uint16_t punctuation_key_2(const char* str)
+static bool is_white_character(char character)
 {
-    return ((std::uint16_t)str[0] << 8) | (std::uint16_t)str[1];
+    return character == ' ' || character == '\t' || character == '\v' || character == '\f' || character == '\r';
 }
 
-static Hash_Table<std::uint16_t, Punctuation, Punctuation::unknown> punctuation_table_2 = {
-    {punctuation_key_2("//"), Punctuation::line_comment},
-    {punctuation_key_2("/*"), Punctuation::open_block_comment},
-    {punctuation_key_2("*/"), Punctuation::close_block_comment},
-    {punctuation_key_2("->"), Punctuation::arrow},
-    {punctuation_key_2("&&"), Punctuation::logical_and},
-    {punctuation_key_2("||"), Punctuation::logical_or},
-    {punctuation_key_2("::"), Punctuation::double_colon},
-    {punctuation_key_2("=="), Punctuation::equality_test},
-    {punctuation_key_2("!="), Punctuation::difference_test},
-};
-
-static Hash_Table<std::uint8_t, Punctuation, Punctuation::unknown> punctuation_table_1 = {
-    // White characters (aren't handle for an implicit skip/separation between tokens)
-    {' ', Punctuation::white_character},       // space
-    {'\t', Punctuation::white_character},      // horizontal tab
-    {'\v', Punctuation::white_character},      // vertical tab
-    {'\f', Punctuation::white_character},      // feed
-    {'\r', Punctuation::white_character},      // carriage return
-    {'\n', Punctuation::new_line_character},   // newline
-    {'~', Punctuation::tilde},
-    {'`', Punctuation::backquote},
-    {'!', Punctuation::bang},
-    {'@', Punctuation::at},
-    {'#', Punctuation::hash},
-    {'$', Punctuation::dollar},
-    {'%', Punctuation::percent},
-    {'^', Punctuation::caret},
-    {'&', Punctuation::ampersand},
-    {'*', Punctuation::star},
-    {'(', Punctuation::open_parenthesis},
-    {')', Punctuation::close_parenthesis},
-//  {'_', Token::underscore},
-    {'-', Punctuation::dash},
-    {'+', Punctuation::plus},
-    {'=', Punctuation::equals},
-    {'{', Punctuation::open_brace},
-    {'}', Punctuation::close_brace},
-    {'[', Punctuation::open_bracket},
-    {']', Punctuation::close_bracket},
-    {':', Punctuation::colon},
-    {';', Punctuation::semicolon},
-    {'\'', Punctuation::single_quote},
-    {'"', Punctuation::double_quote},
-    {'|', Punctuation::pipe},
-    {'/', Punctuation::slash},
-    {'\\', Punctuation::backslash},
-    {'<', Punctuation::less},
-    {'>', Punctuation::greater},
-    {',', Punctuation::comma},
-    {'.', Punctuation::dot},
-    {'?', Punctuation::question_mark}
-};
-
-/// This implemenation doesn't do any lookup in tables
-/// Instead it use hash tables specialized by length of punctuation
-static Punctuation ending_punctuation(const std::string_view& text, int& punctuation_length)
+static bool is_identifier_character(char character)
 {
-    Punctuation punctuation = Punctuation::unknown;
-
-    punctuation_length = 2;
-    if (text.length() >= 2)
-        punctuation = punctuation_table_2[punctuation_key_2(text.data() + text.length() - 2)];
-    if (punctuation != Punctuation::unknown)
-        return punctuation;
-    punctuation_length = 1;
-    if (text.length() >= 1)
-        punctuation = punctuation_table_1[*(text.data() + text.length() - 1)];
-    return punctuation;
+    return (character >= 'a' && character <= 'z')
+        || (character >= 'A' && character <= 'Z')
+        || (character >= '0' && character <= '9')
+        || character == '_';
 }
 
-// @TODO in c++20 put the key as std::string
-static std::unordered_map<std::string_view, Keyword> keywords = {
-	{"include"sv,	Keyword::_include},
-	{"define"sv,	Keyword::_define},
-	{"undef"sv,		Keyword::_undef},
-	{"pragma"sv,	Keyword::_pragma},
-	{"if"sv,		Keyword::_if},
-	{"else"sv,		Keyword::_else},
-	{"elif"sv,		Keyword::_elif},
-	{"endif"sv,		Keyword::_endif},
-	{"ifdef"sv,		Keyword::_ifdef},
-	{"ifndef"sv,	Keyword::_ifndef},
-	{"defined"sv,	Keyword::_defined},
-	{"error"sv,		Keyword::_error},
-};
-
-static Keyword is_keyword(const std::string_view& text)
+static const std::size_t    raw_string_delimiter_max_length = 16;
+
+/// Return true if the prefix that ends just before position is a valid encoding prefix (u8, u, U, L) followed by the given suffix ("" or "R")
+/// @Warning an identifier ending with the same characters isn't a prefix (FOOR"" is an identifier followed by a string)
+static bool is_literal_prefix(const char* begin, const char* position, std::string_view suffix)
 {
-    const auto& it = keywords.find(text);
-    if (it != keywords.end())
-        return it->second;
-    return Keyword::_unknown;
+    if ((size_t)(position - begin) < suffix.length()
+        || std::string_view(position - suffix.length(), suffix.length()) != suffix)
+        return false;
+    position -= suffix.length();
+
+    for (std::string_view encoding : {"u8"sv, "u"sv, "U"sv, "L"sv, ""sv})
+    {
+        if ((size_t)(position - begin) < encoding.length()
+            || std::string_view(position - encoding.length(), encoding.length()) != encoding)
+            continue;
+
+        const char* prefix_start = position - encoding.length();
+
+        if (prefix_start == begin || is_identifier_character(prefix_start[-1]) == false)
+            return true;
+    }
+    return false;
 }
 
-void macro::tokenize(const std::string& buffer, std::vector<Token>& tokens)
+Lexer::Lexer(std::string_view buffer, Tokenize_Mode mode)
+    : m_mode(mode)
+    , m_begin(buffer.data())
+    , m_end(buffer.data() + buffer.length())
+    , m_next_block(buffer.data())
+    , m_line_start(buffer.data())
+    , m_skip_until(buffer.data())
 {
-    tokens.reserve(buffer.length() / tokens_length_heuristic);
-
-	std::string_view	previous_token_text;
-	std::string_view	punctuation_text;
-	const char*			string_views_buffer = buffer.data();	// @Warning all string views are about this string_view_buffer
-    const char*			start_position = buffer.data();
-	const char*			current_position = start_position;
-    int					current_line = 1;
-    int					current_column = 1;
-    int					text_column = 1;
-
-    Token				token;
-	std::string_view	text;
-    Punctuation			punctuation = Punctuation::unknown;
-    int					punctuation_length = 0;
-
-    auto    generateToken = [&](std::string_view text, Punctuation punctuation, size_t column) {
-        token.line = current_line;
-        token.column = column;
-        token.text = text;
-        token.punctuation = punctuation;
-        token.keyword = punctuation == Punctuation::unknown ? is_keyword(text) : Keyword::_unknown;
-
-        tokens.push_back(token);
-    };
+    if (m_mode == Tokenize_Mode::all_tokens)
+        m_tokenizer.start(m_begin, m_end, 1);
+}
 
-    // Extracting token one by one (based on the punctuation)
-    bool    eof = buffer.empty();
-    while (eof == false)
+bool Lexer::next(Token& token)
+{
+    while (true)
     {
-		std::string_view	forward_text;
-        Punctuation			forward_punctuation = Punctuation::unknown;
-        int					forward_punctuation_length = 0;
+        if (m_tokenizer.next(token))
+        {
+            if (m_mode == Tokenize_Mode::all_tokens)
+                m_nb_lines = token.line;
+            return true;
+        }
 
-        if (current_position - string_views_buffer + 2 <= (int)buffer.length())
+        if (m_mode == Tokenize_Mode::all_tokens
+            || scan_next_directive() == false)
+            return false;
+    }
+}
+
+bool Lexer::is_line_start(const char* position) const
+{
+    for (const char* character = m_line_start; character < position; character++) {
+        if (is_white_character(*character) == false)
+            return false;
+    }
+    return true;
+}
+
+void Lexer::flush_directive(const char* position)
+{
+    if (m_state == Scan_State::block_comment && m_directive_end == nullptr)
+        m_directive_end = m_block_comment_start;
+
+    m_tokenizer.start(m_directive_start, m_directive_end ? m_directive_end : position, m_directive_line);
+    m_directive_start = nullptr;
+    m_directive_end = nullptr;
+    m_directive_ready = true;
+}
+
+/// Fast path that only tokenize directive lines (starting with a '#')
+/// The scanner gives positions of characters that can change the state (comments, literals, new lines,...),
+/// all other characters are never looked at, only directive lines are tokenized
+/// Raw string literals, digit separators and line continuations are handled to never take a '#' in a literal
+/// or in a continued line for a directive
+/// @Warning no tokens are stored, the memory used only depends on the number of directives
+/// Return false at the end of the buffer
+bool Lexer::scan_next_directive()
+{
+    m_directive_ready = false;
+
+    while (m_directive_ready == false)
+    {
+        if (m_mask == 0)
         {
-            forward_text = std::string_view(start_position, (current_position - start_position) + 2);
-            forward_punctuation = ending_punctuation(forward_text, forward_punctuation_length);
+            if (m_scan_finished)
+                return false;
+
+            if (m_next_block >= m_end)
+            {
+                m_scan_finished = true;
+
+                if (m_directive_start)
+                    flush_directive(m_end);
+
+                // The number of lines is the line of the last non white character (same as the line of the last token)
+                const char* last_character = m_end;
+                size_t      line = m_line;
+
+                while (last_character > m_begin && (is_white_character(last_character[-1]) || last_character[-1] == '\n'))
+                {
+                    last_character--;
+                    if (*last_character == '\n')
+                        line--;
+                }
+                m_nb_lines = last_character > m_begin ? line : 0;
+                continue;
+            }
+
+            m_block = m_next_block;
+            m_mask = (size_t)(m_end - m_block) >= scanner_block_size ? scan_block(m_block) : scan_tail(m_block, m_end - m_block);
+            m_next_block += scanner_block_size;
+            continue;
         }
 
-        text = std::string_view(start_position, (current_position - start_position) + 1);
-        punctuation = ending_punctuation(text, punctuation_length);
+        const char* position = m_block + count_trailing_zeros(m_mask);
+        char        character = *position;
 
-        if (punctuation == Punctuation::new_line_character)
-            current_column = 0; // 0 because the current_position was not incremented yet, and the cursor is virtually still on previous line
+        m_mask &= m_mask - 1;
 
-        if (punctuation != Punctuation::unknown
-            && (forward_punctuation == Punctuation::unknown
-                || forward_punctuation >= Punctuation::tilde
-                || punctuation <= forward_punctuation))			// @Warning Mutiple characters ponctuation have a lower enum value, <= to manage correctly cases like "///" for comment line
+        if (character == '\n')
         {
-            previous_token_text = std::string_view(text.data(), text.length() - punctuation_length);
-            punctuation_text = std::string_view(text.data() + text.length() - punctuation_length, punctuation_length);
+            m_line++;
+            if (position == m_continued_new_line)
+                continue;
 
-            if (previous_token_text.length())
-                generateToken(previous_token_text, Punctuation::unknown, text_column);
+            if (m_state == Scan_State::line_comment
+                || m_state == Scan_State::string_literal
+                || m_state == Scan_State::char_literal)
+            {
+                m_state = Scan_State::code;  // Unterminated literals end with the line
+            }
 
-            if (is_white_punctuation(punctuation) == false)
-                generateToken(punctuation_text, punctuation, current_column - punctuation_text.length() + 1);
+            if (m_directive_start)
+                flush_directive(position + 1);
 
-            start_position = current_position + 1;
-            text_column = current_column + 1; // text_column comes 1 here after a line return
+            m_line_start = position + 1;
+            continue;
         }
 
-        if (current_position - string_views_buffer + 1 >= (int)buffer.length())
+        if (position < m_skip_until)
+            continue;
+
+        if (character == '\\'
+            && m_state != Scan_State::block_comment
+            && m_state != Scan_State::raw_string_literal)
         {
-            // Handling the case of the last token of stream
-            if (punctuation == Punctuation::unknown)
+            const char* next = position + 1;
+
+            if (next < m_end && *next == '\r')
+                next++;
+            if (next < m_end && *next == '\n')
+                m_continued_new_line = next;
+        }
+
+        switch (m_state)
+        {
+        case Scan_State::code:
+            if (character == '#')
             {
-                previous_token_text = std::string_view(text.data(), text.length());
+                if (m_directive_start == nullptr && is_line_start(position))
+                {
+                    m_directive_start = m_line_start;
+                    m_directive_line = m_line;
+                }
+            }
+            else if (character == '/' && position + 1 < m_end)
+            {
+                if (position[1] == '/')
+                    m_state = Scan_State::line_comment;
+                else if (position[1] == '*')
+                {
+                    m_state = Scan_State::block_comment;
+                    m_block_comment_start = position;
+                }
+                m_skip_until = position + 2;
+            }
+            else if (character == '"')
+            {
+                m_state = Scan_State::string_literal;
+
+                if (is_literal_prefix(m_begin, position, "R"sv))
+                {
+                    const char* delimiter_end = position + 1;
 
-                if (previous_token_text.length())
-                    generateToken(previous_token_text, Punctuation::unknown, text_column);
+                    while (delimiter_end < m_end
+                        && (size_t)(delimiter_end - position - 1) <= raw_string_delimiter_max_length
+                        && *delimiter_end != '('
+                        && *delimiter_end != ')' && *delimiter_end != '\\' && *delimiter_end != '"'
+                        && is_white_character(*delimiter_end) == false && *delimiter_end != '\n')
+                        delimiter_end++;
+
+                    if (delimiter_end < m_end && *delimiter_end == '(')
+                    {
+                        m_state = Scan_State::raw_string_literal;
+                        m_raw_string_delimiter = std::string_view(position + 1, delimiter_end - position - 1);
+                        m_raw_string_start = delimiter_end + 1;
+                        m_skip_until = m_raw_string_start;
+                    }
+                }
             }
+            else if (character == '\'')
+            {
+                // @Warning a quote that follows a number (or an identifier) is a digit separator (1'000'000), except after an encoding prefix (u8'a')
+                if (position == m_begin
+                    || is_identifier_character(position[-1]) == false
+                    || is_literal_prefix(m_begin, position, ""sv))
+                    m_state = Scan_State::char_literal;
+            }
+            break;
 
-            eof = true;
-        }
+        case Scan_State::block_comment:
+            if (character == '/' && position[-1] == '*' && position - 1 >= m_block_comment_start + 2)    // @Warning the '*' of "/*/" doesn't close the comment
+                m_state = Scan_State::code;
+            break;
+
+        case Scan_State::string_literal:
+        case Scan_State::char_literal:
+            if (character == '\\')
+                m_skip_until = position + 2;
+            else if ((character == '"' && m_state == Scan_State::string_literal)
+                || (character == '\'' && m_state == Scan_State::char_literal))
+                m_state = Scan_State::code;
+            break;
 
-        if (punctuation == Punctuation::new_line_character)
-            current_line++;
+        case Scan_State::raw_string_literal:
+            if (character == '"'
+                && (size_t)(position - m_raw_string_start) >= m_raw_string_delimiter.length() + 1
+                && position[-(std::ptrdiff_t)m_raw_string_delimiter.length() - 1] == ')'
+                && std::string_view(position - m_raw_string_delimiter.length(), m_raw_string_delimiter.length()) == m_raw_string_delimiter)
+                m_state = Scan_State::code;
+            break;
 
-        current_column++;
-        current_position++;
+        default:
+            break;
+        }
     }
+    return true;
+}
+
+size_t macro::tokenize(const std::string& buffer, Token_Stream& tokens, Tokenize_Mode mode)
+{
+    Lexer   lexer(buffer, mode);
+    Token   token;
+
+    if (mode == Tokenize_Mode::all_tokens)
+        tokens.reserve(buffer.length() / tokens_length_heuristic);
+
+    while (lexer.next(token))
+        tokens.push_back(token);
+    return lexer.nb_lines();
 }
@@ -1,7 +1,12 @@
 #pragma once
 
+#include "hash_table.hpp"
+#include "keyword_table.hpp"
 #include "macro_language_definitions.hpp"
+#include "token_stream.hpp"
+#include "tokenizer.hpp"
 
+#include <string>
 #include <vector>
 #include <string_view>
 
@@ -25,5 +30,188 @@ namespace macro
 		return lhs.text == rhs.text;
 	}
 
-	void    tokenize(const std::string& text, std::vector<Token>& tokens);
+	using Token_Stream = Packed_Token_Stream<Token>;
+
+	/// Traits of the C/C++ preprocessor language for the Tokenizer
+	struct Language_Definition
+	{
+		using Token = macro::Token;
+		using Punctuation = macro::Punctuation;
+		using Keyword = macro::Keyword;
+
+		static constexpr Punctuation	first_single_character_punctuation = Punctuation::tilde;
+
+		static constexpr Hash_Table<uint16_t, Punctuation, Punctuation::unknown, 8> punctuation_table_2 = {	// Pages of first characters: / * - & | : = !
+			{punctuation_key_2("//"), Punctuation::line_comment},
+			{punctuation_key_2("/*"), Punctuation::open_block_comment},
+			{punctuation_key_2("*/"), Punctuation::close_block_comment},
+			{punctuation_key_2("->"), Punctuation::arrow},
+			{punctuation_key_2("&&"), Punctuation::logical_and},
+			{punctuation_key_2("||"), Punctuation::logical_or},
+			{punctuation_key_2("::"), Punctuation::double_colon},
+			{punctuation_key_2("=="), Punctuation::equality_test},
+			{punctuation_key_2("!="), Punctuation::difference_test},
+		};
+
+		static constexpr Hash_Table<uint8_t, Punctuation, Punctuation::unknown> punctuation_table_1 = {
+			// White characters (aren't handle for an implicit skip/separation between tokens)
+			{' ', Punctuation::white_character},       // space
+			{'\t', Punctuation::white_character},      // horizontal tab
+			{'\v', Punctuation::white_character},      // vertical tab
+			{'\f', Punctuation::white_character},      // feed
+			{'\r', Punctuation::white_character},      // carriage return
+			{'\n', Punctuation::new_line_character},   // newline
+			{'~', Punctuation::tilde},
+			{'`', Punctuation::backquote},
+			{'!', Punctuation::bang},
+			{'@', Punctuation::at},
+			{'#', Punctuation::hash},
+			{'$', Punctuation::dollar},
+			{'%', Punctuation::percent},
+			{'^', Punctuation::caret},
+			{'&', Punctuation::ampersand},
+			{'*', Punctuation::star},
+			{'(', Punctuation::open_parenthesis},
+			{')', Punctuation::close_parenthesis},
+		//  {'_', Token::underscore},
+			{'-', Punctuation::dash},
+			{'+', Punctuation::plus},
+			{'=', Punctuation::equals},
+			{'{', Punctuation::open_brace},
+			{'}', Punctuation::close_brace},
+			{'[', Punctuation::open_bracket},
+			{']', Punctuation::close_bracket},
+			{':', Punctuation::colon},
+			{';', Punctuation::semicolon},
+			{'\'', Punctuation::single_quote},
+			{'"', Punctuation::double_quote},
+			{'|', Punctuation::pipe},
+			{'/', Punctuation::slash},
+			{'\\', Punctuation::backslash},
+			{'<', Punctuation::less},
+			{'>', Punctuation::greater},
+			{',', Punctuation::comma},
+			{'.', Punctuation::dot},
+			{'?', Punctuation::question_mark}
+		};
+
+		static constexpr auto	directive_keywords = make_keyword_table<Keyword>({
+			{std::string_view("include"),	Keyword::_include},
+			{std::string_view("define"),	Keyword::_define},
+			{std::string_view("undef"),		Keyword::_undef},
+			{std::string_view("pragma"),	Keyword::_pragma},
+			{std::string_view("if"),		Keyword::_if},
+			{std::string_view("else"),		Keyword::_else},
+			{std::string_view("elif"),		Keyword::_elif},
+			{std::string_view("endif"),		Keyword::_endif},
+			{std::string_view("ifdef"),		Keyword::_ifdef},
+			{std::string_view("ifndef"),	Keyword::_ifndef},
+			{std::string_view("error"),		Keyword::_error},
+		});
+
+		static bool	is_white_punctuation(Punctuation punctuation) { return macro::is_white_punctuation(punctuation); }
+
+		/// Keywords are only looked for in the name of a directive (identifier after a '#' that starts a line),
+		/// and "defined" in the condition of #if and #elif, other identifiers are never hashed
+		class Keyword_Classifier
+		{
+		public:
+			Keyword	classify(const Token& token)
+			{
+				Keyword	keyword = Keyword::_unknown;
+				bool	start_new_line = token.line > m_last_token_line
+					&& m_last_token_punctuation != Punctuation::backslash;	// @Warning a backslash at the end of the line continues it
+
+				if (start_new_line)
+					m_conditional_directive = false;
+
+				if (token.punctuation == Punctuation::unknown)
+				{
+					if (m_directive_name_expected)
+					{
+						keyword = directive_keywords.find(token.text);
+						m_conditional_directive = keyword == Keyword::_if || keyword == Keyword::_elif;
+					}
+					else if (m_conditional_directive && token.text == std::string_view("defined"))
+						keyword = Keyword::_defined;
+				}
+
+				m_directive_name_expected = start_new_line && token.punctuation == Punctuation::hash;
+				m_last_token_line = token.line;
+				m_last_token_punctuation = token.punctuation;
+				return keyword;
+			}
+
+		private:
+			size_t		m_last_token_line = 0;
+			Punctuation	m_last_token_punctuation = Punctuation::unknown;
+			bool		m_directive_name_expected = false;	// The last token is a '#' that starts a line
+			bool		m_conditional_directive = false;	// In the condition of #if or #elif
+		};
+	};
+
+	enum class Tokenize_Mode
+	{
+		all_tokens,
+		directives	// Fast path that only produces tokens of directive lines (enough for parse_macros)
+	};
+
+	/// Pull based tokenizer, tokens are produced one by one without being stored
+	/// !!! Warning texts of tokens are views in the buffer, it have to outlive the tokens
+	class Lexer
+	{
+	public:
+		Lexer(std::string_view buffer, Tokenize_Mode mode = Tokenize_Mode::all_tokens);
+
+		/// Return false when the end of the buffer is reached
+		bool	next(Token& token);
+
+		/// Return the number of lines (line of the last non white character)
+		/// @Warning only valid once next returned false
+		size_t	nb_lines() const { return m_nb_lines; }
+
+	private:
+		enum class Scan_State : uint8_t
+		{
+			code,
+			line_comment,
+			block_comment,
+			string_literal,
+			char_literal,
+			raw_string_literal
+		};
+
+		bool	scan_next_directive();
+		void	flush_directive(const char* position);
+		bool	is_line_start(const char* position) const;
+
+		Tokenize_Mode		m_mode;
+		const char*			m_begin;
+		const char*			m_end;
+		size_t				m_nb_lines = 0;
+
+		Tokenizer<Language_Definition>	m_tokenizer;	// Tokenization of a range (the whole buffer, or a directive line)
+
+		// Directives scanner
+		const char*			m_next_block;
+		uint64_t			m_mask = 0;
+		const char*			m_block = nullptr;
+		const char*			m_line_start;
+		size_t				m_line = 1;
+		Scan_State			m_state = Scan_State::code;
+		bool				m_scan_finished = false;
+		bool				m_directive_ready = false;
+		const char*			m_skip_until;						// Special characters before this position are already consumed (second character of "//", escaped character,...)
+		const char*			m_block_comment_start = nullptr;
+		const char*			m_continued_new_line = nullptr;		// New line escaped by a backslash (the logical line continues)
+		const char*			m_raw_string_start = nullptr;		// First character after the '(' of the raw string literal
+		std::string_view	m_raw_string_delimiter;
+		const char*			m_directive_start = nullptr;		// Not null while the current line is a directive
+		const char*			m_directive_end = nullptr;			// Set when a block comment starting on the directive line continues on next lines
+		size_t				m_directive_line = 0;
+	};
+
+	/// Store all tokens of the text (wrapper of the Lexer)
+	/// Return the number of lines (line of the last non white character)
+	size_t	tokenize(const std::string& text, Token_Stream& tokens, Tokenize_Mode mode = Tokenize_Mode::all_tokens);
 }
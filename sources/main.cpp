@@ -5,12 +5,16 @@
 
 #include <iostream>
 #include <filesystem>
+#include <string>
+#include <string_view>
+
+#include <stdlib.h>
 
 namespace fs = std::filesystem;
 
 static bool load_configuration_file(const fs::path& path, incg::Configuration& configuration)
 {
-	std::vector<incg::Token>	tokens;
+	incg::Token_Stream			tokens;
 
 	if (read_all_file(path, configuration.__string_views_buffer) == false) {
 		std::cerr << "Error: Failed to read the configuration file " << path <<  "." << std::endl;
@@ -31,21 +35,118 @@ static bool load_configuration_file(const fs::path& path, incg::Configuration& c
 	return true;
 }
 
+static const char*	usage = "Usage: cpp_includes_graph [--scan serial|tasks|pipeline] [--threads <count>] [--projects <count>] [--no-scan-cache] [--watch] [--impact [--from-snapshot]] <configuration file>";
+
+/// Return false if the text isn't a number (0 is allowed, it means a thread per hardware thread)
+static bool parse_count(const char* text, size_t& count)
+{
+	char*	end = nullptr;
+
+	if (text[0] < '0' || text[0] > '9') {
+		return false;	// strtoul accepts signs and spaces
+	}
+	count = (size_t)strtoul(text, &end, 10);
+	return *end == '\0';
+}
+
 int main(int ac, char** av)
 {
-	if (ac != 2) {
-		std::cerr << "Error: No configuration file path specified." << std::endl;
+	Generation_Options	options;
+	const char*			configuration_file_argument = nullptr;
+
+	for (int i = 1; i < ac; i++)
+	{
+		std::string_view	argument = av[i];
+
+		if ((argument == "--threads" || argument == "--projects" || argument == "--scan") && i + 1 >= ac) {
+			std::cerr << "Error: Missing value after " << argument << "." << std::endl << usage << std::endl;
+			return 1;
+		}
+
+		if (argument == "--threads" || argument == "--projects")
+		{
+			size_t&	count = argument == "--threads" ? options.nb_threads : options.nb_concurrent_projects;
+
+			if (parse_count(av[++i], count) == false) {
+				std::cerr << "Error: Invalid count \"" << av[i] << "\" for " << argument << " (a number, 0 for the number of hardware threads)." << std::endl;
+				return 1;
+			}
+		}
+		else if (argument == "--no-scan-cache") {
+			options.use_scan_cache_file = false;
+		}
+		else if (argument == "--watch") {
+			options.watch = true;
+		}
+		else if (argument == "--impact") {
+			options.query_impact = true;
+		}
+		else if (argument == "--from-snapshot") {
+			options.impact_from_snapshot = true;
+		}
+		else if (argument == "--scan")
+		{
+			std::string_view	scan_mode = av[++i];
+
+			if (scan_mode == "serial") {
+				options.scan_mode = Scan_Mode::serial;
+			}
+			else if (scan_mode == "tasks") {
+				options.scan_mode = Scan_Mode::tasks;
+			}
+			else if (scan_mode == "pipeline") {
+				options.scan_mode = Scan_Mode::pipeline;
+			}
+			else {
+				std::cerr << "Error: Unknown scan mode \"" << scan_mode << "\" (serial, tasks or pipeline)." << std::endl;
+				return 1;
+			}
+		}
+		else if (configuration_file_argument == nullptr) {
+			configuration_file_argument = av[i];
+		}
+		else {
+			std::cerr << "Error: Too many arguments, \"" << av[i] << "\" comes after the configuration file path \"" << configuration_file_argument << "\"." << std::endl << usage << std::endl;
+			return 1;
+		}
+	}
+
+	if (configuration_file_argument == nullptr) {
+		std::cerr << "Error: No configuration file path specified." << std::endl << usage << std::endl;
+		return 1;
+	}
+
+	// The snapshot is the graph of the last run, it can't answer for files changed while watching
+	if (options.impact_from_snapshot && (options.query_impact == false || options.watch)) {
+		std::cerr << "Error: --from-snapshot is only for an impact query (--impact), without --watch." << std::endl << usage << std::endl;
 		return 1;
 	}
 
-	fs::path			configuration_file_path = av[1];
+	fs::path			configuration_file_path = configuration_file_argument;
 	incg::Configuration	configuration;
 
 	if (load_configuration_file(configuration_file_path, configuration) == false) {
 		return 2;
 	}
 
-	generate_includes_graph(configuration);
+	// Changed files are given on the standard input, one per line (the output of git diff --name-only), read once
+	// arguments and the configuration are valid, so a mistake doesn't wait for an input that never ends
+	if (options.query_impact)
+	{
+		std::string	line;
+
+		while (std::getline(std::cin, line))
+		{
+			if (line.empty() == false && line.back() == '\r') {
+				line.pop_back();
+			}
+			if (line.empty() == false) {
+				options.changed_files.push_back(line);
+			}
+		}
+	}
+
+	generate_includes_graph(configuration, options);
 
 	return 0;
 }
@@ -0,0 +1,71 @@
+#include "path_table.hpp"
+
+#include <functional>
+
+size_t Path_Table::find_slot(std::string_view path, size_t hash) const
+{
+	size_t		mask = m_slots.size() - 1;
+	uint32_t	tag = slot_hash(hash);
+
+	for (size_t index = hash & mask; ; index = (index + 1) & mask)
+	{
+		const Slot&	slot = m_slots[index];
+
+		if (slot.id == invalid_path_id
+			|| (slot.hash == tag && m_paths[slot.id] == path)) {
+			return index;
+		}
+	}
+}
+
+void Path_Table::grow()
+{
+	std::vector<Slot>	slots(m_slots.empty() ? 1024 : m_slots.size() * 2);
+	size_t				mask = slots.size() - 1;
+
+	for (Path_Id id = 0; id < (Path_Id)m_paths.size(); id++)
+	{
+		size_t	hash = std::hash<std::string_view>()(m_paths[id]);
+		size_t	index = hash & mask;
+
+		while (slots[index].id != invalid_path_id) {
+			index = (index + 1) & mask;
+		}
+		slots[index].hash = slot_hash(hash);
+		slots[index].id = id;
+	}
+	m_slots = std::move(slots);
+}
+
+Path_Id Path_Table::intern(std::string_view path)
+{
+	if ((m_paths.size() + 1) * 2 > m_slots.size()) {
+		grow();
+	}
+
+	size_t	hash = std::hash<std::string_view>()(path);
+	Slot&	slot = m_slots[find_slot(path, hash)];
+
+	if (slot.id == invalid_path_id)
+	{
+		slot.hash = slot_hash(hash);
+		slot.id = (Path_Id)m_paths.size();
+		m_paths.push_back(m_arena.store(path));
+	}
+	return slot.id;
+}
+
+Path_Id Path_Table::find(std::string_view path) const
+{
+	if (m_slots.empty()) {
+		return invalid_path_id;
+	}
+	return m_slots[find_slot(path, std::hash<std::string_view>()(path))].id;
+}
+
+size_t Path_Table::memory_usage() const
+{
+	return m_arena.memory_usage()
+		+ m_paths.capacity() * sizeof(std::string_view)
+		+ m_slots.capacity() * sizeof(Slot);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "utilities.hpp"
+
+#include <string_view>
+#include <vector>
+
+#include <stdint.h>
+
+using Path_Id = uint32_t;
+
+constexpr Path_Id	invalid_path_id = UINT32_MAX;
+
+/// Interned paths, each different path has an id
+/// Ids are dense (0 to size() - 1), so data about paths is stored in vectors indexed by id instead of maps keyed by strings
+/// Texts are packed in a String_Arena and indexed by an open addressing hash table (linear probing), lookups take
+/// a string_view and don't allocate
+/// @Warning paths are compared as texts, they have to be in the same form (generic, normalized,...)
+class Path_Table
+{
+public:
+	/// Return the id of the path, it is added if it isn't in the table yet
+	Path_Id				intern(std::string_view path);
+
+	/// Return invalid_path_id if the path isn't in the table
+	Path_Id				find(std::string_view path) const;
+
+	std::string_view	path(Path_Id id) const { return m_paths[id]; }
+	size_t				size() const { return m_paths.size(); }
+
+	/// Return the number of bytes allocated by the table (texts, ids and slots)
+	size_t				memory_usage() const;
+
+private:
+	struct Slot
+	{
+		uint32_t	hash = 0;				// High bits of the hash, texts are compared only when they match
+		Path_Id		id = invalid_path_id;
+	};
+
+	static uint32_t	slot_hash(size_t hash) { return (uint32_t)(hash >> (sizeof(size_t) * 8 - 32)); }
+
+	/// Return the slot of the path, or the empty slot where it goes
+	size_t			find_slot(std::string_view path, size_t hash) const;
+	void			grow();
+
+	String_Arena					m_arena;
+	std::vector<std::string_view>	m_paths;	// By id
+	std::vector<Slot>				m_slots;	// The size is a power of 2, at most half full
+};
@@ -0,0 +1,196 @@
+#include "scan_cache_file.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+static constexpr char		scan_cache_magic[8] = {'I', 'N', 'C', 'G', 'S', 'C', 'A', 'N'};
+static constexpr uint32_t	scan_cache_version = 1;	// @Warning to increment when the format, or what the parser extracts, changes
+
+/// The file is the header, entries, include records, then texts of spellings
+/// @Warning in the byte order of the machine, the cache isn't meant to be shared between machines
+struct Scan_Cache_File::Header
+{
+	char		magic[8];
+	uint32_t	version;
+	uint32_t	nb_entries;
+	uint64_t	nb_includes;
+	uint64_t	strings_size;
+};
+
+struct Scan_Cache_File::Entry
+{
+	uint64_t	device;
+	uint64_t	file;
+	uint64_t	size;
+	int64_t		modification_time;
+	uint64_t	nb_lines;
+	uint32_t	first_include;
+	uint32_t	nb_includes;
+
+	bool	operator<(const Entry& other) const { return device < other.device || (device == other.device && file < other.file); }
+};
+
+struct Scan_Cache_File::Include_Record
+{
+	uint32_t	offset;		// In texts
+	uint32_t	length;
+	uint32_t	type;		// macro::Include_Type
+};
+
+void Scan_Cache_File::close()
+{
+	m_entries = nullptr;
+	m_nb_entries = 0;
+	m_includes = nullptr;
+	m_nb_includes = 0;
+	m_strings = nullptr;
+	m_strings_size = 0;
+	m_file.close();
+}
+
+bool Scan_Cache_File::load(const fs::path& file_path)
+{
+	close();
+	if (fs::exists(file_path) == false || m_file.open(file_path) == false) {
+		return false;
+	}
+
+	std::string_view	data = m_file.view();
+	Header				header;
+
+	if (data.size() < sizeof(Header)) {
+		return false;
+	}
+	memcpy(&header, data.data(), sizeof(Header));
+	if (memcmp(header.magic, scan_cache_magic, sizeof(scan_cache_magic)) != 0
+		|| header.version != scan_cache_version
+		|| data.size() != sizeof(Header) + header.nb_entries * sizeof(Entry) + header.nb_includes * sizeof(Include_Record) + header.strings_size) {
+		return false;	// Another version, or a truncated file
+	}
+
+	// @Warning the buffer of File_View and mapped files are aligned enough for records
+	m_entries = (const Entry*)(data.data() + sizeof(Header));
+	m_nb_entries = header.nb_entries;
+	m_includes = (const Include_Record*)(data.data() + sizeof(Header) + header.nb_entries * sizeof(Entry));
+	m_nb_includes = (size_t)header.nb_includes;
+	m_strings = data.data() + sizeof(Header) + header.nb_entries * sizeof(Entry) + header.nb_includes * sizeof(Include_Record);
+	m_strings_size = (size_t)header.strings_size;
+	return true;
+}
+
+const Scan_Cache_File::Entry* Scan_Cache_File::find_entry(const File_Identity& identity, const File_Version& version) const
+{
+	Entry	key = {};
+
+	key.device = identity.device;
+	key.file = identity.file;
+
+	const Entry*	entry = std::lower_bound(m_entries, m_entries + m_nb_entries, key);
+
+	if (entry == m_entries + m_nb_entries
+		|| entry->device != identity.device
+		|| entry->file != identity.file) {
+		return nullptr;
+	}
+	if (entry->size != version.size
+		|| entry->modification_time != version.modification_time) {
+		return nullptr;	// Stale, the file changed since it was scanned
+	}
+	if ((size_t)entry->first_include + entry->nb_includes > m_nb_includes) {
+		return nullptr;
+	}
+	return entry;
+}
+
+bool Scan_Cache_File::contains(const File_Identity& identity, const File_Version& version) const
+{
+	return find_entry(identity, version) != nullptr;
+}
+
+bool Scan_Cache_File::find(const File_Identity& identity, const File_Version& version, std::vector<macro::Include>& includes, size_t& nb_lines) const
+{
+	const Entry*	entry = find_entry(identity, version);
+
+	if (entry == nullptr) {
+		return false;
+	}
+
+	size_t	first_include = includes.size();
+
+	for (uint32_t i = 0; i < entry->nb_includes; i++)
+	{
+		const Include_Record&	record = m_includes[entry->first_include + i];
+
+		if ((size_t)record.offset + record.length > m_strings_size) {
+			includes.resize(first_include);	// A corrupted entry is a miss
+			return false;
+		}
+		includes.push_back({(macro::Include_Type)record.type, std::string_view(m_strings + record.offset, record.length)});
+	}
+	nb_lines = (size_t)entry->nb_lines;
+	return true;
+}
+
+bool Scan_Cache_File::save(const fs::path& file_path, std::vector<Saved_Scan>& scans)
+{
+	std::sort(scans.begin(), scans.end(), [](const Saved_Scan& a, const Saved_Scan& b) {
+		return a.identity.device < b.identity.device || (a.identity.device == b.identity.device && a.identity.file < b.identity.file);
+	});
+
+	Header						header;
+	std::vector<Entry>			entries;
+	std::vector<Include_Record>	includes;
+	std::string					strings;
+
+	entries.reserve(scans.size());
+	for (const Saved_Scan& scan : scans)
+	{
+		Entry	entry;
+
+		entry.device = scan.identity.device;
+		entry.file = scan.identity.file;
+		entry.size = scan.version.size;
+		entry.modification_time = scan.version.modification_time;
+		entry.nb_lines = scan.nb_lines;
+		entry.first_include = (uint32_t)includes.size();
+		entry.nb_includes = (uint32_t)scan.nb_includes;
+		for (size_t i = 0; i < scan.nb_includes; i++)
+		{
+			includes.push_back({(uint32_t)strings.size(), (uint32_t)scan.includes[i].path.length(), (uint32_t)scan.includes[i].type});
+			strings += scan.includes[i].path;
+		}
+		entries.push_back(entry);
+	}
+
+	memcpy(header.magic, scan_cache_magic, sizeof(scan_cache_magic));
+	header.version = scan_cache_version;
+	header.nb_entries = (uint32_t)entries.size();
+	header.nb_includes = includes.size();
+	header.strings_size = strings.size();
+
+	fs::path		temporary_path = file_path;
+	std::ofstream	file;
+
+	temporary_path += ".tmp";
+	file.open(temporary_path, std::fstream::out | std::fstream::binary | std::fstream::trunc);
+	if (file.is_open() == false) {
+		return false;
+	}
+	file.write((const char*)&header, sizeof(Header));
+	file.write((const char*)entries.data(), entries.size() * sizeof(Entry));
+	file.write((const char*)includes.data(), includes.size() * sizeof(Include_Record));
+	file.write(strings.data(), strings.size());
+	file.close();
+	if (file.fail()) {
+		return false;
+	}
+
+	std::error_code	error;
+
+	fs::rename(temporary_path, file_path, error);
+	return !error;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "macro_parser.hpp"
+#include "utilities.hpp"
+
+#include <filesystem>
+#include <vector>
+
+/// Scans of files (includes and number of lines) kept on disk between runs, so unchanged files aren't read again
+/// Entries are keyed by the identity of files and are valid while their version (size and modification time) is the same
+/// Nothing is parsed at load: the file is mapped (File_View), entries are sorted by identity and found by a binary search,
+/// spellings of includes are views in the file
+/// @Warning a file modified without a change of its size in the resolution of the modification time isn't seen
+class Scan_Cache_File
+{
+public:
+	struct Saved_Scan
+	{
+		File_Identity			identity;
+		File_Version			version;
+		size_t					nb_lines;
+		const macro::Include*	includes;
+		size_t					nb_includes;
+	};
+
+	Scan_Cache_File() = default;
+	Scan_Cache_File(const Scan_Cache_File&) = delete;
+
+	Scan_Cache_File&	operator=(const Scan_Cache_File&) = delete;
+
+	/// Return false if there is no valid cache file at this path, the cache is then empty
+	bool				load(const std::filesystem::path& file_path);
+
+	/// Unmap the file, the cache is empty (the file can then be replaced, even on Windows)
+	void				close();
+
+	/// Append includes of the file if its entry is up to date, spellings are valid until the cache is destroyed
+	bool				find(const File_Identity& identity, const File_Version& version, std::vector<macro::Include>& includes, size_t& nb_lines) const;
+
+	/// Return true if the entry of the file is up to date
+	bool				contains(const File_Identity& identity, const File_Version& version) const;
+
+	size_t				size() const { return m_nb_entries; }
+
+	/// Write scans in a temporary file that replaces the previous cache once complete (an interrupted run doesn't leave
+	/// a broken cache)
+	/// @Warning scans are sorted by identity
+	static bool			save(const std::filesystem::path& file_path, std::vector<Saved_Scan>& scans);
+
+private:
+	struct Header;
+	struct Entry;
+	struct Include_Record;
+
+	const Entry*		find_entry(const File_Identity& identity, const File_Version& version) const;
+
+	File_View				m_file;
+	const Entry*			m_entries = nullptr;	// Sorted by identity
+	size_t					m_nb_entries = 0;
+	const Include_Record*	m_includes = nullptr;
+	size_t					m_nb_includes = 0;
+	const char*				m_strings = nullptr;
+	size_t					m_strings_size = 0;
+};
@@ -1,23 +1,113 @@
+#include "../hash_table.hpp"
 #include "../macro_tokenizer.hpp"
 #include "../macro_parser.hpp"
+#include "../macro_scanner.hpp"
+#include "../directory_index.hpp"
+#include "../file_graph.hpp"
+#include "../graph_snapshot.hpp"
+#include "../scan_cache_file.hpp"
 
 #include <CppUnitTest.h>
 
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
 #include <vector>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
 using namespace macro;
 
+namespace fs = std::filesystem;
+
 namespace tests
 {
+	/// Run the test with the full tokenization and with the directives fast path for every scanner supported by the CPU
+	template<typename Test>
+	static void for_each_tokenize_path(Test test)
+	{
+		Scanner_Implementation	default_implementation = get_scanner_implementation();
+
+		test(Tokenize_Mode::all_tokens);
+		for (Scanner_Implementation implementation : {Scanner_Implementation::scalar, Scanner_Implementation::sse2, Scanner_Implementation::avx2})
+		{
+			if (set_scanner_implementation(implementation)) {
+				test(Tokenize_Mode::directives);
+			}
+		}
+		set_scanner_implementation(default_implementation);
+	}
+
+	/// Check that the directives fast path gives the same tokens as the full tokenization for directive lines
+	static void check_directives_tokens(const std::string& text, const std::vector<size_t>& directive_lines)
+	{
+		Token_Stream		all_tokens;
+		std::vector<Token>	expected_tokens;
+		size_t				nb_lines = tokenize(text, all_tokens);
+
+		for (const Token& token : all_tokens)
+		{
+			if (std::find(directive_lines.begin(), directive_lines.end(), token.line) != directive_lines.end()) {
+				expected_tokens.push_back(token);
+			}
+		}
+
+		for_each_tokenize_path([&](Tokenize_Mode mode) {
+			Token_Stream	tokens;
+
+			Assert::AreEqual(tokenize(text, tokens, mode), nb_lines);
+			if (mode == Tokenize_Mode::all_tokens) {
+				return;
+			}
+
+			Assert::AreEqual(tokens.size(), expected_tokens.size());
+			for (size_t i = 0; i < tokens.size(); i++)
+			{
+				Assert::AreEqual(std::string(tokens[i].text), std::string(expected_tokens[i].text));
+				Assert::AreEqual((int)tokens[i].punctuation, (int)expected_tokens[i].punctuation);
+				Assert::AreEqual((int)tokens[i].keyword, (int)expected_tokens[i].keyword);
+				Assert::AreEqual(tokens[i].line, expected_tokens[i].line);
+				Assert::AreEqual(tokens[i].column, expected_tokens[i].column);
+			}
+		});
+	}
+
+	/// Check that a file saved by save isn't loaded when it is missing, truncated, or of another version (the version is
+	/// right after the magic in files of the tool)
+	template<typename Saved_File, typename Save>
+	static void check_rejected_files(const fs::path& file_path, Save save)
+	{
+		Saved_File	saved_file;
+
+		fs::remove(file_path);
+		Assert::IsFalse(saved_file.load(file_path));
+
+		save(file_path);
+		fs::resize_file(file_path, fs::file_size(file_path) - 1);
+		Assert::IsFalse(saved_file.load(file_path));
+
+		save(file_path);
+		{
+			std::fstream	file(file_path, std::fstream::in | std::fstream::out | std::fstream::binary);
+			uint32_t		version = 0;
+
+			file.seekp(8);
+			file.write((const char*)&version, sizeof(version));
+		}
+		Assert::IsFalse(saved_file.load(file_path));
+
+		saved_file.close();
+		fs::remove(file_path);
+	}
+
 	TEST_CLASS(macro_tokenizer_tests)
 	{
 	public:
 		
 		TEST_METHOD(empty_text)
 		{
-			std::vector<Token>	tokens;
+			Token_Stream		tokens;
 			std::string			text =
 				"";
 
@@ -28,7 +118,7 @@ namespace tests
 
 		TEST_METHOD(white_spaces_text)
 		{
-			std::vector<Token>	tokens;
+			Token_Stream		tokens;
 			std::string			text =
 				"  \t  \r\n";
 
@@ -39,7 +129,7 @@ namespace tests
 
 		TEST_METHOD(comment_line_text_01)
 		{
-			std::vector<Token>	tokens;
+			Token_Stream		tokens;
 			std::string			text =
 				"// ";
 
@@ -51,7 +141,7 @@ namespace tests
 
 		TEST_METHOD(comment_line_text_02)
 		{
-			std::vector<Token>	tokens;
+			Token_Stream		tokens;
 			std::string			text =
 				"/// ";
 
@@ -63,7 +153,7 @@ namespace tests
 
 		TEST_METHOD(comment_line_text_03)
 		{
-			std::vector<Token>	tokens;
+			Token_Stream		tokens;
 			std::string			text =
 				"///\r\n"
 				"///\r\n";
@@ -83,7 +173,7 @@ namespace tests
 
 		TEST_METHOD(include_text)
 		{
-			std::vector<Token>	tokens;
+			Token_Stream		tokens;
 			std::string			text =
 				"/// comment\r\n"
 				"\r\n"
@@ -101,6 +191,122 @@ namespace tests
 			Assert::AreEqual(std::string(tokens[6].text), std::string("string"));
 			Assert::AreEqual((int)tokens[7].punctuation, (int)Punctuation::greater);
 		}
+
+		TEST_METHOD(directives_text)
+		{
+			std::string			text =
+				"/// comment\r\n"
+				"\r\n"
+				"  #include <string>\r\n"
+				"int main() { return 0; } # not a directive\n"
+				"#define MAX(a, b) ((a) > (b) ? (a) : (b)) // comment\n"
+				"\t#endif";
+
+			check_directives_tokens(text, {3, 5, 6});
+		}
+
+		TEST_METHOD(directives_in_comments_and_literals_text)
+		{
+			std::string			text =
+				"/* #include <comment_01>\n"
+				"#include <comment_02> */ #include <not_line_start>\n"
+				"const char* s = \"#include <string_01>\\\" /*\";\n"
+				"char c = '\"'; char d = '\\''; // \"\n"
+				"#include \"first.h\"\n"
+				"/* #include <comment_03>\n"
+				"*/\n"
+				"#include <second.h>\n";
+
+			check_directives_tokens(text, {5, 8});
+		}
+
+		TEST_METHOD(directives_raw_strings_text)
+		{
+			std::string			text =
+				"const char* a = R\"(\n"
+				"#include <raw_01>\n"
+				")\";\n"
+				"const char* b = u8R\"delimiter(\n"
+				")\" #include <raw_02> )other\"\n"
+				")delimiter\"; const char* c = FOOR\"(\";\n"
+				"#include <first.h>\n";
+
+			check_directives_tokens(text, {7});
+		}
+
+		TEST_METHOD(directives_continuations_text)
+		{
+			std::string			text =
+				"#define MULTI_LINE(a) \\\n"
+				"    a + \\\r\n"
+				"    #a\n"
+				"int a = 0; \\\n"
+				"#include <continued_01>\n"
+				"// comment \\\n"
+				"#include <continued_02>\n"
+				"#include \\\n"
+				"    <second.h>\n"
+				"int b = 1'000'000; // \"\n"
+				"#include <third.h>\n"
+				"char c = u8'\"';\n"
+				"#include <fourth.h>\n";
+
+			check_directives_tokens(text, {1, 2, 3, 8, 9, 11, 13});
+		}
+
+		TEST_METHOD(directives_long_text)
+		{
+			std::string			text;
+
+			// Lines of various lengths to put special characters on both sides of the scanner blocks boundaries
+			for (size_t i = 0; i < 100; i++)
+			{
+				text += std::string(i % 7, ' ') + "#include \"file_" + std::to_string(i) + ".h\"\n";
+				text += "/*" + std::string(i, '*') + "*/ int a_" + std::to_string(i) + " = '\\'';\n";
+				text += "const char* s_" + std::to_string(i) + " = \"" + std::string(i, '\\') + "\";\n";
+			}
+
+			std::vector<size_t>	directive_lines;
+
+			for (size_t i = 0; i < 100; i++) {
+				directive_lines.push_back(i * 3 + 1);
+			}
+			check_directives_tokens(text, directive_lines);
+		}
+
+		TEST_METHOD(keywords_text)
+		{
+			std::string			text =
+				"if (defined) include; # define\n"
+				"  # if defined(A) && \\\n"
+				"  defined B\n"
+				"#ifdef defined\n"
+				"#elif !defined(C) // include\n"
+				"#include_next <a.h>\n"
+				"#pragma include";
+
+			for_each_tokenize_path([&](Tokenize_Mode mode) {
+				Token_Stream				tokens;
+				std::vector<std::string>	keywords;
+
+				tokenize(text, tokens, mode);
+				for (const Token& token : tokens)
+				{
+					if (token.keyword != Keyword::_unknown) {
+						keywords.push_back(std::string(token.text));
+					}
+				}
+
+				Assert::AreEqual(keywords.size(), size_t(7));
+				Assert::AreEqual(keywords[0], std::string("if"));
+				Assert::AreEqual(keywords[1], std::string("defined"));
+				Assert::AreEqual(keywords[2], std::string("defined"));
+				Assert::AreEqual(keywords[3], std::string("ifdef"));
+				Assert::AreEqual(keywords[4], std::string("elif"));
+				Assert::AreEqual(keywords[5], std::string("defined"));
+				Assert::AreEqual(keywords[6], std::string("pragma"));
+			});
+		}
 	};
 
 	TEST_CLASS(macro_parser)
@@ -109,62 +315,504 @@ namespace tests
 
 		TEST_METHOD(includes)
 		{
-			Macro_Parsing_Result	parsing_result;
-			std::vector<Token>		tokens;
-			std::string				text =
-				"#include <string>\r\n"
-				"#include \"assert.h\"";
+			for_each_tokenize_path([](Tokenize_Mode mode) {
+				Macro_Parsing_Result	parsing_result;
+				Token_Stream			tokens;
+				std::string				text =
+					"#include <string>\r\n"
+					"#include \"assert.h\"";
 
-			tokenize(text, tokens);
+				tokenize(text, tokens, mode);
 
-			parse_macros(tokens, parsing_result);
+				parse_macros(tokens, parsing_result);
 
-			Assert::AreEqual(parsing_result.includes.size(), size_t(2));
+				Assert::AreEqual(parsing_result.includes.size(), size_t(2));
+			});
 		}
 
 		TEST_METHOD(glm_hpp_bug_01)
 		{
-			Macro_Parsing_Result	parsing_result;
-			std::vector<Token>		tokens;
-			std::string				text =
-				"/// comment\r\n"
-				"\r\n"
-				"#include <string>\r\n";
+			for_each_tokenize_path([](Tokenize_Mode mode) {
+				Macro_Parsing_Result	parsing_result;
+				Token_Stream			tokens;
+				std::string				text =
+					"/// comment\r\n"
+					"\r\n"
+					"#include <string>\r\n";
 
-			tokenize(text, tokens);
+				tokenize(text, tokens, mode);
 
-			parse_macros(tokens, parsing_result);
+				parse_macros(tokens, parsing_result);
 
-			Assert::AreEqual(parsing_result.includes.size(), size_t(1));
+				Assert::AreEqual(parsing_result.includes.size(), size_t(1));
+			});
 		}
 
 		TEST_METHOD(glm_hpp_bug_02)
 		{
-			Macro_Parsing_Result	parsing_result;
-			std::vector<Token>		tokens;
-			std::string				text =
+			for_each_tokenize_path([](Tokenize_Mode mode) {
+				Macro_Parsing_Result	parsing_result;
+				Token_Stream			tokens;
+				std::string				text =
+					"/// <a href=\"http://www.opengl.org/registry/doc/GLSLangSpec.4.20.8.clean.pdf\">version 4.2\n"
+					"\n"
+					"#include \"detail/_fixes.hpp\"\n";
+
+				tokenize(text, tokens, mode);
+
+				parse_macros(tokens, parsing_result);
+
+				Assert::AreEqual(parsing_result.includes.size(), size_t(1));
+			});
+		}
+		TEST_METHOD(bug_01)
+		{
+			for_each_tokenize_path([](Tokenize_Mode mode) {
+				Macro_Parsing_Result	parsing_result;
+				Token_Stream			tokens;
+				std::string				text =
+					"#include <detail/_fixes.hpp> // include test\n";
+
+				tokenize(text, tokens, mode);
+
+				parse_macros(tokens, parsing_result);
+
+				Assert::AreEqual(parsing_result.includes.size(), size_t(1));
+			});
+		}
+
+		TEST_METHOD(line_continuations)
+		{
+			for_each_tokenize_path([](Tokenize_Mode mode) {
+				Macro_Parsing_Result	parsing_result;
+				Token_Stream			tokens;
+				std::string				text =
+					"int a = 0; \\\n"
+					"#include <continued_01>\n"
+					"// comment \\\r\n"
+					"#include <continued_02>\n"
+					"#include \\\n"
+					"    <first.h>\n";
+
+				tokenize(text, tokens, mode);
+
+				parse_macros(tokens, parsing_result);
+
+				Assert::AreEqual(parsing_result.includes.size(), size_t(1));
+				Assert::AreEqual(std::string(parsing_result.includes[0].path), std::string("first.h"));
+			});
+		}
+
+		TEST_METHOD(include_word_in_directives)
+		{
+			for_each_tokenize_path([](Tokenize_Mode mode) {
+				Macro_Parsing_Result	parsing_result;
+				Token_Stream			tokens;
+				std::string				text =
+					"#if defined(DOXYGEN) /* Don't show <stdint.h> include */\n"
+					"#elif !defined (VMS) \\\n"
+					"  && (__STDC_VERSION__ >= 199901L) /* C99 */\n"
+					"#  include MACRO_HEADER\n"
+					"#  include <inttypes.h>\n"
+					"#endif\n";
+
+				tokenize(text, tokens, mode);
+
+				parse_macros(tokens, parsing_result);
+
+				Assert::AreEqual(parsing_result.includes.size(), size_t(1));
+				Assert::AreEqual(std::string(parsing_result.includes[0].path), std::string("inttypes.h"));
+			});
+		}
+
+		TEST_METHOD(fused_parsing)
+		{
+			std::vector<std::string>	texts = {
+				"#include <string>\r\n"
+				"#include \"assert.h\"",
 				"/// <a href=\"http://www.opengl.org/registry/doc/GLSLangSpec.4.20.8.clean.pdf\">version 4.2\n"
 				"\n"
-				"#include \"detail/_fixes.hpp\"\n";
+				"#include \"detail/_fixes.hpp\"\n",
+				"#include \"first.h\" /* comment\n"
+				"#include <commented.h>\n"
+				"*/\n"
+				"#include \\\n"
+				"    <second.h> // include test\n",
+			};
+
+			for (const std::string& text : texts)
+			{
+				for_each_tokenize_path([&text](Tokenize_Mode mode) {
+					Macro_Parsing_Result	parsing_result;
+					Token_Stream			tokens;
+					std::vector<Include>	includes;
+					Lexer					lexer(text, mode);
+
+					size_t	nb_lines = tokenize(text, tokens, mode);
+					parse_macros(tokens, parsing_result);
+
+					parse_macros(lexer, [&includes](const Include& include) {
+						includes.push_back(include);
+					});
+
+					Assert::AreEqual(lexer.nb_lines(), nb_lines);
+					Assert::AreEqual(includes.size(), parsing_result.includes.size());
+					for (size_t i = 0; i < includes.size(); i++)
+					{
+						Assert::AreEqual(std::string(includes[i].path), std::string(parsing_result.includes[i].path));
+						Assert::AreEqual((int)includes[i].type, (int)parsing_result.includes[i].type);
+					}
+				});
+			}
+		}
 
-			tokenize(text, tokens);
+		TEST_METHOD(block_comment_after_include)
+		{
+			for_each_tokenize_path([](Tokenize_Mode mode) {
+				Macro_Parsing_Result	parsing_result;
+				Token_Stream			tokens;
+				std::string				text =
+					"#include \"first.h\" /* comment\n"
+					"#include <commented.h>\n"
+					"*/\n"
+					"#include <second.h>\n";
+
+				tokenize(text, tokens, mode);
+
+				parse_macros(tokens, parsing_result);
+
+				Assert::AreEqual(parsing_result.includes.size(), size_t(2));
+				Assert::AreEqual(std::string(parsing_result.includes[0].path), std::string("first.h"));
+				Assert::AreEqual(std::string(parsing_result.includes[1].path), std::string("second.h"));
+			});
+		}
+	};
 
-			parse_macros(tokens, parsing_result);
+	TEST_CLASS(hash_table)
+	{
+	public:
 
-			Assert::AreEqual(parsing_result.includes.size(), size_t(1));
+		TEST_METHOD(all_pages)
+		{
+			static const Hash_Table<uint16_t, int, 0>	table = {{0x0041, 5}, {0x2A2F, 6}, {0xFFFF, 7}};	// Each page is stored, keys < 256 in the first one
+
+			Assert::AreEqual(table[0x0041], 5);
+			Assert::AreEqual(table[0x2A2F], 6);
+			Assert::AreEqual(table[0xFFFF], 7);
+			Assert::AreEqual(table[0x0000], 0);
+			Assert::AreEqual(table[0x4100], 0);
+			Assert::AreEqual(Hash_Table<uint16_t, int, 0>::memory_usage(), size_t(256 + 256 * 256 * sizeof(int)));
 		}
-		TEST_METHOD(bug_01)
+
+		TEST_METHOD(default_page)
 		{
-			Macro_Parsing_Result	parsing_result;
-			std::vector<Token>		tokens;
-			std::string				text =
-				"#include <detail/_fixes.hpp> // include test\n";
+			constexpr Hash_Table<uint16_t, int, -1, 2>	table = {{0x0041, 5}, {0x0042, 6}, {0x2A2F, 7}};
+
+			Assert::AreEqual(table[0x0041], 5);
+			Assert::AreEqual(table[0x0042], 6);
+			Assert::AreEqual(table[0x2A2F], 7);
+			Assert::AreEqual(table[0x0043], -1);
+			Assert::AreEqual(table[0x2A00], -1);
+			Assert::AreEqual(table[0x4100], -1);	// Entries without a page share the default one
+			Assert::AreEqual(Hash_Table<uint16_t, int, -1, 2>::memory_usage(), size_t(256 + 3 * 256 * sizeof(int)));
+
+			Assert::ExpectException<std::logic_error>([]() { Hash_Table<uint16_t, int, -1, 2>({{0x0041, 5}, {0x2A2F, 6}, {0x3A3A, 7}}); });
+			Assert::ExpectException<std::logic_error>([]() { Hash_Table<uint16_t, int, -1, 2>({{0x0041, 5}, {0x0041, 6}}); });
+		}
 
-			tokenize(text, tokens);
+		TEST_METHOD(no_stored_page)
+		{
+			constexpr Hash_Table<uint16_t, int, -1, 0>	table;
+
+			Assert::AreEqual(table[0x0000], -1);
+			Assert::AreEqual(table[0xFFFF], -1);
+			Assert::ExpectException<std::logic_error>([]() { Hash_Table<uint16_t, int, -1, 0>({{0x0041, 5}}); });
+		}
+	};
+
+	TEST_CLASS(file_graph)
+	{
+	public:
+
+		TEST_METHOD(freeze)
+		{
+			Arena		arena;
+			File_Graph	graph(arena);
+			Node_Id		source = graph.add_node(0, 0, 0, File_Type::source, true);
+			Node_Id		first = graph.add_node(1, 1, 0, File_Type::header, true);
+			Node_Id		second = graph.add_node(2, 2, 0, File_Type::header, false);
+			Node_Id		common = graph.add_node(3, 3, 0, File_Type::header, true);
+
+			graph.add_edge(source, second);	// Children keep the order of includes, not the order of ids
+			graph.add_edge(source, first);
+			graph.add_edge(first, common);
+			graph.add_edge(second, common);
+
+			Assert::IsFalse(graph.is_frozen());
+			graph.freeze();
+			Assert::IsTrue(graph.is_frozen());
+
+			Assert::AreEqual(graph.nb_nodes(), size_t(4));
+			Assert::AreEqual(graph.nb_edges(), size_t(4));
+			Assert::AreEqual(graph.children(source).size(), size_t(2));
+			Assert::AreEqual(graph.children(source).begin()[0], second);
+			Assert::AreEqual(graph.children(source).begin()[1], first);
+			Assert::AreEqual(graph.children(common).size(), size_t(0));
+			Assert::AreEqual(graph.parents(source).size(), size_t(0));
+			Assert::AreEqual(graph.parents(common).size(), size_t(2));
+			Assert::AreEqual(graph.parents(common).begin()[0], first);
+			Assert::AreEqual(graph.parents(common).begin()[1], second);
+			Assert::AreEqual(graph.nb_inclusions(common), size_t(2));
+			Assert::AreEqual(graph.paths(second).label, Path_Id(2));
+			Assert::IsFalse(graph.attributes(second).file_found);
+		}
+
+		TEST_METHOD(ancestors_with_cycle)
+		{
+			Arena		arena;
+			File_Graph	graph(arena);
+			Node_Id		source = graph.add_node(0, 0, 0, File_Type::source, true);
+			Node_Id		first = graph.add_node(1, 1, 0, File_Type::header, true);
+			Node_Id		second = graph.add_node(2, 2, 0, File_Type::header, true);
+			Node_Id		other_source = graph.add_node(3, 3, 0, File_Type::source, true);
+			Node_Id		alone = graph.add_node(4, 4, 0, File_Type::source, true);
+
+			graph.add_edge(source, first);
+			graph.add_edge(first, second);
+			graph.add_edge(second, first);	// Headers including each other
+			graph.add_edge(other_source, second);
+			graph.freeze();
+
+			std::vector<Node_Id>	reached;
+
+			graph.ancestors({second}, reached);	// Breadth first, each node once
+			Assert::AreEqual(reached.size(), size_t(4));
+			Assert::AreEqual(reached[0], second);
+			Assert::AreEqual(reached[1], first);
+			Assert::AreEqual(reached[2], other_source);
+			Assert::AreEqual(reached[3], source);
+
+			graph.ancestors({alone, alone}, reached);	// Appended, a given node is its own ancestor
+			Assert::AreEqual(reached.size(), size_t(5));
+			Assert::AreEqual(reached[4], alone);
+
+			reached.clear();
+			graph.ancestors({}, reached);
+			Assert::AreEqual(reached.size(), size_t(0));
+		}
+	};
+
+	TEST_CLASS(scan_cache_file)
+	{
+	public:
 
-			parse_macros(tokens, parsing_result);
+		/// Scans of two files, the second one without includes (saved in the reverse order of identities)
+		static void save_scans(const fs::path& file_path)
+		{
+			static const Include	includes[] = {{Include_Type::local, "first.h"}, {Include_Type::external, "dir/second.h"}};
+
+			std::vector<Scan_Cache_File::Saved_Scan>	scans = {
+				{{1, 20}, {100, 1000}, 42, includes, 2},
+				{{1, 10}, {200, 2000}, 7, nullptr, 0}};
+
+			Assert::IsTrue(Scan_Cache_File::save(file_path, scans));
+		}
+
+		TEST_METHOD(round_trip)
+		{
+			fs::path				file_path = fs::temp_directory_path() / "incg_tests.scan_cache";
+			Scan_Cache_File			cache;
+			std::vector<Include>	includes;
+			size_t					nb_lines = 0;
+
+			save_scans(file_path);
+			Assert::IsTrue(cache.load(file_path));
+			Assert::AreEqual(cache.size(), size_t(2));
+
+			Assert::IsTrue(cache.find({1, 20}, {100, 1000}, includes, nb_lines));
+			Assert::AreEqual(nb_lines, size_t(42));
+			Assert::AreEqual(includes.size(), size_t(2));
+			Assert::AreEqual(std::string(includes[0].path), std::string("first.h"));
+			Assert::AreEqual((int)includes[0].type, (int)Include_Type::local);
+			Assert::AreEqual(std::string(includes[1].path), std::string("dir/second.h"));
+			Assert::AreEqual((int)includes[1].type, (int)Include_Type::external);
+
+			Assert::IsTrue(cache.find({1, 10}, {200, 2000}, includes, nb_lines));	// Includes are appended
+			Assert::AreEqual(nb_lines, size_t(7));
+			Assert::AreEqual(includes.size(), size_t(2));
+
+			Assert::IsFalse(cache.contains({2, 20}, {100, 1000}));	// Another device
+			Assert::IsFalse(cache.contains({1, 15}, {100, 1000}));
+
+			cache.close();
+			fs::remove(file_path);
+		}
+
+		TEST_METHOD(stale_entry)
+		{
+			fs::path				file_path = fs::temp_directory_path() / "incg_tests_stale.scan_cache";
+			Scan_Cache_File			cache;
+			std::vector<Include>	includes;
+			size_t					nb_lines = 0;
+
+			save_scans(file_path);
+			Assert::IsTrue(cache.load(file_path));
+
+			Assert::IsFalse(cache.find({1, 20}, {101, 1000}, includes, nb_lines));	// Another size
+			Assert::IsFalse(cache.find({1, 20}, {100, 1001}, includes, nb_lines));	// Another modification time
+			Assert::IsFalse(cache.contains({1, 20}, {100, 1001}));
+			Assert::AreEqual(includes.size(), size_t(0));
+			Assert::AreEqual(nb_lines, size_t(0));
+
+			cache.close();
+			fs::remove(file_path);
+		}
+
+		TEST_METHOD(rejected_files)
+		{
+			check_rejected_files<Scan_Cache_File>(fs::temp_directory_path() / "incg_tests_rejected.scan_cache", save_scans);
+		}
+	};
+
+	TEST_CLASS(graph_snapshot)
+	{
+	public:
 
-			Assert::AreEqual(parsing_result.includes.size(), size_t(1));
+		/// A source including two headers that include each other, a header not found and a source including nothing
+		static void build_graph(File_Graph& graph, std::vector<Node_Texts>& texts, std::vector<Node_Id>& root_nodes)
+		{
+			Node_Id	source = graph.add_node(0, 1, 2, File_Type::source, true);
+			Node_Id	first = graph.add_node(3, 4, 2, File_Type::header, true);
+			Node_Id	second = graph.add_node(5, 6, 2, File_Type::header, true);
+			Node_Id	missing = graph.add_node(7, 7, 2, File_Type::header, false);
+			Node_Id	alone = graph.add_node(8, 9, 2, File_Type::source, true);
+
+			graph.attributes(source).nb_lines = 120;
+			graph.attributes(first).nb_lines = 30;
+			graph.add_edge(source, second);
+			graph.add_edge(source, first);
+			graph.add_edge(first, second);
+			graph.add_edge(second, first);
+			graph.add_edge(second, missing);
+			graph.freeze();
+
+			texts = {
+				{"lib/main.cpp", "/project/lib/main.cpp"},
+				{"first.h", "/project/lib/first.h"},
+				{"second.h", "/project/lib/second.h"},
+				{"missing.h", "missing.h"},	// The label is the path
+				{"lib/alone.cpp", "/project/lib/alone.cpp"}};
+			root_nodes = {source, alone};
+		}
+
+		TEST_METHOD(round_trip)
+		{
+			fs::path				file_path = fs::temp_directory_path() / "incg_tests.graph";
+			Arena					arena;
+			File_Graph				graph(arena);
+			std::vector<Node_Texts>	texts;
+			std::vector<Node_Id>	root_nodes;
+			Graph_Snapshot			snapshot;
+
+			build_graph(graph, texts, root_nodes);
+			Assert::IsTrue(Graph_Snapshot::save(file_path, graph, texts, root_nodes));
+			Assert::IsTrue(snapshot.load(file_path));
+
+			Assert::AreEqual(snapshot.nb_nodes(), graph.nb_nodes());
+			Assert::AreEqual(snapshot.nb_edges(), graph.nb_edges());
+			Assert::IsTrue(std::equal(snapshot.root_nodes().begin(), snapshot.root_nodes().end(), root_nodes.begin(), root_nodes.end()));
+			for (Node_Id node = 0; node < (Node_Id)graph.nb_nodes(); node++)
+			{
+				Assert::IsTrue(std::equal(snapshot.children(node).begin(), snapshot.children(node).end(), graph.children(node).begin(), graph.children(node).end()));
+				Assert::IsTrue(std::equal(snapshot.parents(node).begin(), snapshot.parents(node).end(), graph.parents(node).begin(), graph.parents(node).end()));
+				Assert::AreEqual(std::string(snapshot.label(node)), std::string(texts[node].label));
+				Assert::AreEqual(std::string(snapshot.path(node)), std::string(texts[node].path));
+				Assert::AreEqual(snapshot.attributes(node).nb_lines, graph.attributes(node).nb_lines);
+				Assert::AreEqual((int)snapshot.attributes(node).file_type, (int)graph.attributes(node).file_type);
+				Assert::AreEqual(snapshot.attributes(node).file_found, graph.attributes(node).file_found);
+				Assert::AreEqual(snapshot.nb_inclusions(node), graph.nb_inclusions(node));
+			}
+
+			std::vector<Node_Id>	reached;
+			std::vector<Node_Id>	snapshot_reached;
+
+			graph.ancestors({3}, reached);
+			snapshot.ancestors({3}, snapshot_reached);
+			Assert::AreEqual(snapshot_reached.size(), size_t(4));	// Through the cycle, each node once
+			Assert::IsTrue(snapshot_reached == reached);
+
+			snapshot.close();
+			fs::remove(file_path);
+		}
+
+		TEST_METHOD(rejected_files)
+		{
+			Arena					arena;
+			File_Graph				graph(arena);
+			std::vector<Node_Texts>	texts;
+			std::vector<Node_Id>	root_nodes;
+
+			build_graph(graph, texts, root_nodes);
+			check_rejected_files<Graph_Snapshot>(fs::temp_directory_path() / "incg_tests_rejected.graph", [&](const fs::path& file_path) {
+				Assert::IsTrue(Graph_Snapshot::save(file_path, graph, texts, root_nodes));
+			});
+		}
+	};
+	TEST_CLASS(directory_index)
+	{
+	public:
+
+		/// root/a.h, root/sub/b.h and root/.git/config
+		static fs::path create_tree()
+		{
+			fs::path	root = fs::temp_directory_path() / "incg_tests_directory_index";
+
+			fs::remove_all(root);
+			fs::create_directories(root / "sub");
+			fs::create_directories(root / ".git");
+			for (const char* file : {"a.h", "sub/b.h", ".git/config"}) {
+				std::ofstream(root / file) << "\n";
+			}
+			return root;
+		}
+
+		TEST_METHOD(shared_roots)
+		{
+			fs::path						root = create_tree();
+			Directory_Index					index;
+			Directory_Index::Lookup_Stats	lookups;
+			auto							is_walked_directory = [](std::string_view name) { return name != ".git"; };
+
+			index.add_roots({root / "sub"}, is_walked_directory);
+			Assert::AreEqual(index.stats().nb_roots, size_t(1));
+			Assert::AreEqual(index.stats().nb_builds, size_t(1));
+
+			index.add_roots({root, root / "sub"}, is_walked_directory);	// Replaces the nested root
+			index.add_roots({root}, is_walked_directory);				// Already indexed, not enumerated again
+			Assert::AreEqual(index.stats().nb_roots, size_t(1));
+			Assert::AreEqual(index.stats().nb_builds, size_t(2));
+			Assert::AreEqual(index.stats().nb_pruned_directories, size_t(1));
+
+			Assert::IsTrue(index.exists(root / "a.h", lookups));
+			Assert::IsTrue(index.exists(root / "sub/../sub/b.h", lookups));
+			Assert::IsFalse(index.exists(root / "c.h", lookups));
+			Assert::AreEqual(lookups.nb_index_lookups, size_t(3));
+			Assert::AreEqual(lookups.nb_fallbacks, size_t(0));
+
+			Assert::IsTrue(index.exists(root / ".git", lookups));
+			Assert::IsTrue(index.exists(root / ".git/config", lookups));	// Pruned, checked on the file system
+			Assert::AreEqual(lookups.nb_index_lookups, size_t(4));
+			Assert::AreEqual(lookups.nb_fallbacks, size_t(1));
+
+			std::ofstream(root / "c.h") << "\n";
+			Assert::IsFalse(index.exists(root / "c.h", lookups));	// Not seen until the root is forgotten
+			index.forget_root(root / "sub");
+			Assert::AreEqual(index.stats().nb_roots, size_t(0));
+			index.add_roots({root}, is_walked_directory);
+			Assert::IsTrue(index.exists(root / "c.h", lookups));
+			Assert::AreEqual(index.stats().nb_builds, size_t(3));
+
+			fs::remove_all(root);
 		}
 	};
 }
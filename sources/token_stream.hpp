@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <cassert>
+#include <stdint.h>
+
+/// Compact storage of tokens as parallel arrays (13 bytes per token instead of 40 for a Token)
+/// Tokens are rebuilt on access, so it can be used like a read only std::vector<Token>
+/// !!! Warning texts of tokens are stored as offsets in the tokenized buffer, it have to outlive the stream
+///
+/// Token_Type have to provide punctuation (8 bits enum with less than 128 values), keyword, text, line and column members.
+template<typename Token_Type>
+class Packed_Token_Stream
+{
+	using Punctuation = decltype(Token_Type::punctuation);
+	using Keyword = decltype(Token_Type::keyword);
+
+	static constexpr uint16_t	long_length = std::numeric_limits<uint16_t>::max();	// The real length is stored in m_long_lengths
+	static constexpr uint8_t	keyword_flag = 0x80;
+
+public:
+	class const_iterator
+	{
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = Token_Type;
+		using difference_type = std::ptrdiff_t;
+		using pointer = void;
+		using reference = Token_Type;
+
+		const_iterator(const Packed_Token_Stream* stream, size_t index) : m_stream(stream), m_index(index) {}
+
+		Token_Type		operator*() const { return (*m_stream)[m_index]; }
+		const_iterator&	operator++() { m_index++; return *this; }
+		const_iterator	operator++(int) { const_iterator it = *this; m_index++; return it; }
+		bool			operator==(const const_iterator& other) const { return m_index == other.m_index; }
+		bool			operator!=(const const_iterator& other) const { return m_index != other.m_index; }
+		difference_type	operator-(const const_iterator& other) const { return (difference_type)m_index - (difference_type)other.m_index; }
+
+	private:
+		const Packed_Token_Stream*	m_stream;
+		size_t				m_index;
+	};
+
+	void	reserve(size_t nb_tokens)
+	{
+		m_offsets.reserve(nb_tokens);
+		m_lengths.reserve(nb_tokens);
+		m_lines.reserve(nb_tokens);
+		m_columns.reserve(nb_tokens);
+		m_classes.reserve(nb_tokens);
+	}
+
+	void	clear()
+	{
+		m_buffer = nullptr;
+		m_offsets.clear();
+		m_lengths.clear();
+		m_lines.clear();
+		m_columns.clear();
+		m_classes.clear();
+		m_long_lengths.clear();
+	}
+
+	void	push_back(const Token_Type& token)
+	{
+		if (m_offsets.empty()) {
+			m_buffer = token.text.data();	// @Warning offsets are relative to the first token (tokens are pushed in the order of the buffer)
+		}
+
+		size_t	offset = token.text.data() - m_buffer;
+
+		assert(token.text.data() >= m_buffer && offset <= std::numeric_limits<uint32_t>::max());	// Buffers bigger than 4GB aren't supported
+		assert((uint8_t)token.punctuation < keyword_flag);
+
+		m_offsets.push_back((uint32_t)offset);
+		if (token.text.length() >= long_length)
+		{
+			m_lengths.push_back(long_length);
+			m_long_lengths.push_back(std::pair<uint32_t, uint32_t>((uint32_t)m_offsets.size() - 1, (uint32_t)token.text.length()));
+		}
+		else {
+			m_lengths.push_back((uint16_t)token.text.length());
+		}
+		m_lines.push_back((uint32_t)token.line);
+		m_columns.push_back((uint16_t)std::min<size_t>(token.column, std::numeric_limits<uint16_t>::max()));	// @Warning columns of very long lines are saturated
+		m_classes.push_back(token.keyword != Keyword()
+			? (uint8_t)(keyword_flag | (uint8_t)token.keyword)
+			: (uint8_t)token.punctuation);
+	}
+
+	Token_Type	operator[](size_t index) const
+	{
+		Token_Type	token;
+		uint8_t		token_class = m_classes[index];
+
+		if (token_class & keyword_flag) {
+			token.keyword = (Keyword)(token_class & ~keyword_flag);
+		}
+		else {
+			token.punctuation = (Punctuation)token_class;
+		}
+		token.text = std::string_view(m_buffer + m_offsets[index], length(index));
+		token.line = m_lines[index];
+		token.column = m_columns[index];
+		return token;
+	}
+
+	size_t			size() const { return m_offsets.size(); }
+	bool			empty() const { return m_offsets.empty(); }
+	Token_Type		back() const { return (*this)[size() - 1]; }
+	const_iterator	begin() const { return const_iterator(this, 0); }
+	const_iterator	end() const { return const_iterator(this, size()); }
+
+	/// Return the number of bytes allocated by the stream
+	size_t	memory_usage() const
+	{
+		return m_offsets.capacity() * sizeof(uint32_t)
+			+ m_lengths.capacity() * sizeof(uint16_t)
+			+ m_lines.capacity() * sizeof(uint32_t)
+			+ m_columns.capacity() * sizeof(uint16_t)
+			+ m_classes.capacity() * sizeof(uint8_t)
+			+ m_long_lengths.capacity() * sizeof(std::pair<uint32_t, uint32_t>);
+	}
+
+private:
+	size_t	length(size_t index) const
+	{
+		if (m_lengths[index] != long_length) {
+			return m_lengths[index];
+		}
+
+		auto	it = std::lower_bound(m_long_lengths.begin(), m_long_lengths.end(), (uint32_t)index,
+			[](const std::pair<uint32_t, uint32_t>& long_length, uint32_t index) { return long_length.first < index; });
+		return it->second;
+	}
+
+	const char*								m_buffer = nullptr;
+	std::vector<uint32_t>					m_offsets;
+	std::vector<uint16_t>					m_lengths;
+	std::vector<uint32_t>					m_lines;
+	std::vector<uint16_t>					m_columns;
+	std::vector<uint8_t>					m_classes;			// Punctuation, or Keyword with the keyword_flag
+	std::vector<std::pair<uint32_t, uint32_t>>	m_long_lengths;	// Token index and length of tokens longer than 65534 bytes
+};
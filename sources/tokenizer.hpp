@@ -0,0 +1,156 @@
+#pragma once
+
+#include <string_view>
+
+#include <stdint.h>
+
+/// Return a key for the punctuation of 2 characters
+constexpr uint16_t punctuation_key_2(const char* str)
+{
+	return (uint16_t)(((uint16_t)(uint8_t)str[0] << 8) | (uint16_t)(uint8_t)str[1]);
+}
+
+/// Pull based tokenizer shared by languages, tokens are produced one by one from a range of a buffer
+/// The language is given by a definition with constexpr traits:
+///  - Token, Punctuation and Keyword types
+///  - punctuation_table_1 and punctuation_table_2: Hash_Table of punctuations of 1 and 2 characters (key from punctuation_key_2)
+///  - first_single_character_punctuation: multiple characters punctuations have lower values, they have the priority
+///  - is_white_punctuation(Punctuation): white punctuations separate tokens without producing one
+///  - Keyword_Classifier: a class with a Keyword classify(const Token&) method, called on each token in order
+/// !!! Warning texts of tokens are views in the buffer, it have to outlive the tokens
+template<typename Language>
+class Tokenizer
+{
+	using Token = typename Language::Token;
+	using Punctuation = typename Language::Punctuation;
+
+public:
+	/// Tokenize the range [begin, end) that have to start at the beginning of the line first_line
+	void	start(const char* begin, const char* end, size_t first_line)
+	{
+		m_range_end = end;
+		m_start_position = begin;
+		m_current_position = begin;
+		m_current_line = first_line;
+		m_current_column = 1;
+		m_text_column = 1;
+	}
+
+	/// Return false at the end of the range
+	bool	next(Token& token)
+	{
+		while (m_pending_begin == m_pending_end && m_current_position < m_range_end)
+		{
+			m_pending_begin = 0;
+			m_pending_end = 0;
+			tokenize_character();
+		}
+
+		if (m_pending_begin == m_pending_end)
+			return false;
+
+		token = m_pending_tokens[m_pending_begin++];
+		return true;
+	}
+
+private:
+	/// This implemenation doesn't do any lookup in tables
+	/// Instead it use hash tables specialized by length of punctuation
+	static Punctuation	ending_punctuation(const std::string_view& text, int& punctuation_length)
+	{
+		Punctuation	punctuation = Punctuation::unknown;
+
+		punctuation_length = 2;
+		if (text.length() >= 2)
+			punctuation = Language::punctuation_table_2[punctuation_key_2(text.data() + text.length() - 2)];
+		if (punctuation != Punctuation::unknown)
+			return punctuation;
+		punctuation_length = 1;
+		if (text.length() >= 1)
+			punctuation = Language::punctuation_table_1[(uint8_t)*(text.data() + text.length() - 1)];
+		return punctuation;
+	}
+
+	void	generate_token(std::string_view text, Punctuation punctuation, size_t column)
+	{
+		Token&	token = m_pending_tokens[m_pending_end++];
+
+		token.line = m_current_line;
+		token.column = column;
+		token.text = text;
+		token.punctuation = punctuation;
+		token.keyword = m_keyword_classifier.classify(token);
+	}
+
+	/// Consume one character of the range, this can produce up to 2 pending tokens
+	void	tokenize_character()
+	{
+		std::string_view	previous_token_text;
+		std::string_view	punctuation_text;
+		std::string_view	text;
+		Punctuation			punctuation = Punctuation::unknown;
+		int					punctuation_length = 0;
+		std::string_view	forward_text;
+		Punctuation			forward_punctuation = Punctuation::unknown;
+		int					forward_punctuation_length = 0;
+
+		if (m_current_position + 2 <= m_range_end)
+		{
+			forward_text = std::string_view(m_start_position, (m_current_position - m_start_position) + 2);
+			forward_punctuation = ending_punctuation(forward_text, forward_punctuation_length);
+		}
+
+		text = std::string_view(m_start_position, (m_current_position - m_start_position) + 1);
+		punctuation = ending_punctuation(text, punctuation_length);
+
+		if (punctuation == Punctuation::new_line_character)
+			m_current_column = 0; // 0 because the current_position was not incremented yet, and the cursor is virtually still on previous line
+
+		if (punctuation != Punctuation::unknown
+			&& (forward_punctuation == Punctuation::unknown
+				|| forward_punctuation >= Language::first_single_character_punctuation
+				|| punctuation <= forward_punctuation))			// @Warning Mutiple characters ponctuation have a lower enum value, <= to manage correctly cases like "///" for comment line
+		{
+			previous_token_text = std::string_view(text.data(), text.length() - punctuation_length);
+			punctuation_text = std::string_view(text.data() + text.length() - punctuation_length, punctuation_length);
+
+			if (previous_token_text.length())
+				generate_token(previous_token_text, Punctuation::unknown, m_text_column);
+
+			if (Language::is_white_punctuation(punctuation) == false)
+				generate_token(punctuation_text, punctuation, m_current_column - punctuation_text.length() + 1);
+
+			m_start_position = m_current_position + 1;
+			m_text_column = m_current_column + 1; // text_column comes 1 here after a line return
+		}
+
+		if (m_current_position + 1 >= m_range_end)
+		{
+			// Handling the case of the last token of stream
+			if (punctuation == Punctuation::unknown)
+			{
+				previous_token_text = std::string_view(text.data(), text.length());
+
+				if (previous_token_text.length())
+					generate_token(previous_token_text, Punctuation::unknown, m_text_column);
+			}
+		}
+
+		if (punctuation == Punctuation::new_line_character)
+			m_current_line++;
+
+		m_current_column++;
+		m_current_position++;
+	}
+
+	const char*							m_range_end = nullptr;
+	const char*							m_start_position = nullptr;
+	const char*							m_current_position = nullptr;
+	size_t								m_current_line = 1;
+	size_t								m_current_column = 1;
+	size_t								m_text_column = 1;
+	Token								m_pending_tokens[2];	// A character can end a text token and be a punctuation token
+	uint8_t								m_pending_begin = 0;
+	uint8_t								m_pending_end = 0;
+	typename Language::Keyword_Classifier	m_keyword_classifier;
+};
@@ -1,23 +1,393 @@
 #include "utilities.hpp"
 
-#include <fstream>
+#include <algorithm>
+
+#if defined(_WIN32)
+#	define NOMINMAX
+#	define WIN32_LEAN_AND_MEAN
+#	include <windows.h>
+#	include <psapi.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/resource.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#	include <cerrno>
+#endif
 
 namespace fs = std::filesystem;
 
 bool read_all_file(const fs::path& file_path, std::string& data)
 {
-	std::ifstream   file(file_path, std::fstream::binary);
-	std::streampos  file_size;
+	File_View	file;
 
-	if (file.is_open() == false) {
+	if (file.open(file_path) == false) {
 		return false;
 	}
 
-	file.seekg(0, file.end);
-	file_size = file.tellg();
-	file.seekg(0, file.beg);
+	data.assign(file.view());
+	return true;
+}
+
+size_t	File_View::mapping_threshold = 64 * 1024;
+
+File_View::File_View(File_View&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+File_View::~File_View()
+{
+	close();
+}
+
+void File_View::adopt(std::unique_ptr<char[]> buffer, size_t size)
+{
+	close();
+	m_buffer = std::move(buffer);
+	m_buffer_capacity = size;
+	m_data = m_buffer.get();
+	m_size = size;
+}
+
+char* File_View::reserve_buffer(size_t size)
+{
+	if (size > m_buffer_capacity)
+	{
+		m_buffer.reset(new char[size]);
+		m_buffer_capacity = size;
+	}
+	return m_buffer.get();
+}
+
+File_View& File_View::operator=(File_View&& other) noexcept
+{
+	if (this != &other)
+	{
+		close();
+		m_data = other.m_data;
+		m_size = other.m_size;
+		m_mapped = other.m_mapped;
+		m_buffer = std::move(other.m_buffer);
+		m_buffer_capacity = other.m_buffer_capacity;
+
+		other.m_data = nullptr;
+		other.m_size = 0;
+		other.m_mapped = false;
+		other.m_buffer_capacity = 0;
+	}
+	return *this;
+}
+
+#if defined(_WIN32)
+
+bool File_View::open(const fs::path& file_path, Access access)
+{
+	close();
+
+	HANDLE			file = CreateFileW(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, access == Access::random ? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	LARGE_INTEGER	file_size;
+	bool			result = true;
+
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	if (GetFileSizeEx(file, &file_size) == FALSE) {
+		CloseHandle(file);
+		return false;
+	}
 
-	data.resize((size_t)file_size);
-	file.read(reinterpret_cast<char*>(data.data()), data.size());
-	return file.fail() == false;
+	size_t	size = (size_t)file_size.QuadPart;
+
+	if ((size >= mapping_threshold || access == Access::random) && size > 0)
+	{
+		HANDLE	mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		if (mapping != nullptr)
+		{
+			m_data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+			CloseHandle(mapping);	// @Warning the view keeps the mapping alive
+		}
+		if (m_data != nullptr)
+		{
+			m_size = size;
+			m_mapped = true;
+			CloseHandle(file);
+			return true;
+		}
+	}
+
+	// Buffered read
+	char*	buffer = reserve_buffer(size);
+
+	while (m_size < size)
+	{
+		DWORD	nb_read = 0;
+		DWORD	to_read = (DWORD)std::min<size_t>(size - m_size, 1u << 30);
+
+		if (ReadFile(file, buffer + m_size, to_read, &nb_read, nullptr) == FALSE) {
+			result = false;
+			break;
+		}
+		if (nb_read == 0) {
+			break;	// The file was truncated
+		}
+		m_size += nb_read;
+	}
+	m_data = buffer;
+	CloseHandle(file);
+	return result;
+}
+
+void File_View::close()
+{
+	if (m_mapped) {
+		UnmapViewOfFile(m_data);
+	}
+	m_data = nullptr;
+	m_size = 0;
+	m_mapped = false;	// @Warning the buffer is kept for the next file
+}
+
+#else
+
+bool File_View::open(const fs::path& file_path, Access access)
+{
+	close();
+
+	int			file = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+	struct stat	file_status;
+	bool		result = true;
+
+	if (file < 0) {
+		return false;
+	}
+	if (fstat(file, &file_status) != 0
+		|| S_ISREG(file_status.st_mode) == false) {	// @Warning directories can be opened
+		::close(file);
+		return false;
+	}
+
+	size_t	size = (size_t)file_status.st_size;
+
+	if ((size >= mapping_threshold || access == Access::random) && size > 0)
+	{
+		int		flags = MAP_PRIVATE;
+#if defined(MAP_POPULATE)
+		if (access == Access::sequential) {
+			flags |= MAP_POPULATE;	// Read the whole file in one time instead of a page fault per page
+		}
+#endif
+		void*	address = mmap(nullptr, size, PROT_READ, flags, file, 0);
+
+		if (address != MAP_FAILED)
+		{
+			madvise(address, size, access == Access::random ? MADV_RANDOM : MADV_SEQUENTIAL);
+			m_data = static_cast<const char*>(address);
+			m_size = size;
+			m_mapped = true;
+			::close(file);	// @Warning the mapping stays valid
+			return true;
+		}
+	}
+
+	// Buffered read
+	char*	buffer = reserve_buffer(size);
+
+	while (m_size < size)
+	{
+		ssize_t	nb_read = ::read(file, buffer + m_size, size - m_size);
+
+		if (nb_read < 0)
+		{
+			if (errno == EINTR) {
+				continue;
+			}
+			result = false;
+			break;
+		}
+		if (nb_read == 0) {
+			break;	// The file was truncated
+		}
+		m_size += (size_t)nb_read;
+	}
+	m_data = buffer;
+	::close(file);
+	return result;
+}
+
+void File_View::close()
+{
+	if (m_mapped) {
+		munmap(const_cast<char*>(m_data), m_size);
+	}
+	m_data = nullptr;
+	m_size = 0;
+	m_mapped = false;	// @Warning the buffer is kept for the next file
+}
+
+#endif
+
+std::string_view String_Arena::intern(std::string_view text)
+{
+	if (text.empty()) {
+		return std::string_view();
+	}
+
+	auto	it = m_strings.find(text);
+
+	if (it != m_strings.end()) {
+		return *it;
+	}
+
+	return *m_strings.insert(store(text)).first;
+}
+
+std::string_view String_Arena::store(std::string_view text)
+{
+	if (text.empty()) {
+		return std::string_view();
+	}
+
+	char*	copy;
+
+	if (text.length() > block_size / 4)	// @Warning big strings have their own block to not waste the end of the current one
+	{
+		std::unique_ptr<char[]>	block(new char[text.length()]);
+
+		copy = block.get();
+		m_blocks.insert(m_blocks.empty() ? m_blocks.end() : m_blocks.end() - 1, std::move(block));	// The current block stays the last one
+		m_blocks_memory += text.length();
+	}
+	else
+	{
+		if (block_size - m_block_used < text.length())
+		{
+			m_blocks.emplace_back(new char[block_size]);
+			m_blocks_memory += block_size;
+			m_block_used = 0;
+		}
+		copy = m_blocks.back().get() + m_block_used;
+		m_block_used += text.length();
+	}
+
+	std::copy(text.begin(), text.end(), copy);
+	return std::string_view(copy, text.length());
+}
+
+size_t String_Arena::memory_usage() const
+{
+	return m_blocks_memory
+		+ m_blocks.capacity() * sizeof(std::unique_ptr<char[]>)
+		+ m_strings.bucket_count() * sizeof(void*)
+		+ m_strings.size() * (sizeof(std::string_view) + 2 * sizeof(void*));	// Approximation of nodes of the std::unordered_set
+}
+
+void* Arena::allocate(size_t size, size_t alignment)
+{
+	size_t	offset = (m_block_used + alignment - 1) & ~(alignment - 1);	// @Warning blocks are aligned on alignof(std::max_align_t) by new
+	char*	memory;
+
+	m_stats.nb_allocations++;
+	if (size > block_size / 4)	// @Warning big allocations have their own block to not waste the end of the current one
+	{
+		std::unique_ptr<char[]>	block(new char[size]);
+
+		memory = block.get();
+		m_blocks.insert(m_blocks.empty() ? m_blocks.end() : m_blocks.end() - 1, std::move(block));	// The current block stays the last one
+		m_stats.reserved_bytes += size;
+		m_stats.used_bytes += size;
+	}
+	else
+	{
+		if (offset + size > block_size)
+		{
+			m_blocks.emplace_back(new char[block_size]);
+			m_stats.reserved_bytes += block_size;
+			m_block_used = 0;
+			offset = 0;
+		}
+		memory = m_blocks.back().get() + offset;
+		m_stats.used_bytes += offset + size - m_block_used;
+		m_block_used = offset + size;
+	}
+	m_stats.nb_blocks = m_blocks.size();
+	m_stats.high_water_mark = std::max(m_stats.high_water_mark, m_stats.reserved_bytes);
+	return memory;
+}
+
+void Arena::release()
+{
+	m_blocks.clear();
+	m_block_used = block_size;
+	m_stats.nb_blocks = 0;
+	m_stats.used_bytes = 0;
+	m_stats.reserved_bytes = 0;
+}
+
+bool get_file_identity(const fs::path& file_path, File_Identity& identity, File_Version* version)
+{
+#if defined(_WIN32)
+	HANDLE	handle = CreateFileW(file_path.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+
+	if (handle == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	BY_HANDLE_FILE_INFORMATION	information;
+	BOOL						succeeded = GetFileInformationByHandle(handle, &information);
+
+	CloseHandle(handle);
+	if (succeeded == FALSE) {
+		return false;
+	}
+	identity.device = information.dwVolumeSerialNumber;
+	identity.file = ((uint64_t)information.nFileIndexHigh << 32) | information.nFileIndexLow;
+	if (version) {
+		version->size = ((uint64_t)information.nFileSizeHigh << 32) | information.nFileSizeLow;
+		version->modification_time = (int64_t)(((uint64_t)information.ftLastWriteTime.dwHighDateTime << 32) | information.ftLastWriteTime.dwLowDateTime) * 100;	// FILETIME is in 100 ns
+	}
+	return true;
+#else
+	struct stat	status;
+
+	if (stat(file_path.c_str(), &status) != 0) {
+		return false;
+	}
+	identity.device = (uint64_t)status.st_dev;
+	identity.file = (uint64_t)status.st_ino;
+	if (version) {
+#	if defined(__APPLE__)
+		version->modification_time = (int64_t)status.st_mtimespec.tv_sec * 1000000000 + status.st_mtimespec.tv_nsec;
+#	else
+		version->modification_time = (int64_t)status.st_mtim.tv_sec * 1000000000 + status.st_mtim.tv_nsec;
+#	endif
+		version->size = (uint64_t)status.st_size;
+	}
+	return true;
+#endif
+}
+
+size_t peak_memory_usage()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS	counters;
+
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) == FALSE) {
+		return 0;
+	}
+	return counters.PeakWorkingSetSize;
+#else
+	struct rusage	usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return 0;
+	}
+#	if defined(__APPLE__)
+	return (size_t)usage.ru_maxrss;			// In bytes
+#	else
+	return (size_t)usage.ru_maxrss * 1024;	// In kilobytes
+#	endif
+#endif
 }
@@ -1,6 +1,179 @@
 #pragma once
 
 #include <filesystem>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include <stdint.h>
 
 bool read_all_file(const std::filesystem::path& file_path, std::string& data);
+
+/// Read only content of a file
+/// Files bigger than mapping_threshold are memory mapped (no copy, pages are read ahead sequentially),
+/// smaller ones are read in a buffer because mapping them costs more than a read
+/// Files opened for a random access are always mapped, only touched pages are read (opening is O(1))
+/// The buffer is kept between files (only grown), so a File_View can be reused to read many files without allocations
+/// !!! Warning the view is only valid until the File_View is closed or destroyed
+class File_View
+{
+public:
+	static size_t	mapping_threshold;	// In bytes, tunable
+
+	enum class Access : uint8_t
+	{
+		sequential,	// Read from the start to the end (sources), mapped pages are all read at once
+		random		// A few parts are read (indexed files), always mapped whatever the size, pages are read when touched
+	};
+
+	File_View() = default;
+	File_View(const File_View&) = delete;
+	File_View(File_View&& other) noexcept;
+	~File_View();
+
+	File_View&	operator=(const File_View&) = delete;
+	File_View&	operator=(File_View&& other) noexcept;
+
+	/// Return false if the file can't be read (or isn't a regular file)
+	bool				open(const std::filesystem::path& file_path, Access access = Access::sequential);
+	void				close();
+
+	/// Take the ownership of a buffer that contains a file
+	void				adopt(std::unique_ptr<char[]> buffer, size_t size);
+
+	std::string_view	view() const { return std::string_view(m_data, m_size); }
+	bool				is_mapped() const { return m_mapped; }
+
+private:
+	char*	reserve_buffer(size_t size);
+
+	const char*				m_data = nullptr;
+	size_t					m_size = 0;
+	bool					m_mapped = false;
+	std::unique_ptr<char[]>	m_buffer;	// @Warning not zero initialized, it is fully overwritten by the read
+	size_t					m_buffer_capacity = 0;
+};
+
+/// Identity of a physical file, the same for all paths that lead to it (relative paths, symbolic links, hard links)
+struct File_Identity
+{
+	uint64_t	device;
+	uint64_t	file;	// Inode, or file index on Windows
+
+	bool	operator==(const File_Identity& other) const { return device == other.device && file == other.file; }
+};
+
+struct File_Identity_Hash
+{
+	size_t	operator()(const File_Identity& identity) const { return std::hash<uint64_t>()(identity.file * 31 + identity.device); }
+};
+
+/// Size and modification time of a file, a file whose version is the same is considered unchanged
+struct File_Version
+{
+	uint64_t	size;
+	int64_t		modification_time;	// In nanoseconds, from an epoch given by the system
+
+	bool	operator==(const File_Version& other) const { return size == other.size && modification_time == other.modification_time; }
+};
+
+/// Return false if the file doesn't exist or if the system doesn't give identities of files
+/// The version is filled too if it is given (same system call)
+bool	get_file_identity(const std::filesystem::path& file_path, File_Identity& identity, File_Version* version = nullptr);
+
+/// Storage of strings that live as long as the arena, identical strings are stored once
+/// Strings are packed in big blocks, so it is much more compact than a std::string per string
+class String_Arena
+{
+public:
+	/// Return a view on the copy of the text owned by the arena
+	std::string_view	intern(std::string_view text);
+
+	/// Return a view on a new copy of the text, without looking for an identical string (the caller does it)
+	std::string_view	store(std::string_view text);
+
+	/// Return the number of bytes allocated by the arena (blocks and the index of strings)
+	size_t				memory_usage() const;
+
+private:
+	static constexpr size_t	block_size = 64 * 1024;
+
+	std::vector<std::unique_ptr<char[]>>	m_blocks;
+	size_t									m_blocks_memory = 0;
+	size_t									m_block_used = block_size;	// Used bytes of the last block
+	std::unordered_set<std::string_view>	m_strings;
+};
+
+/// Monotonic allocator: memory is taken from big blocks by moving an offset, nothing is freed until the arena is released,
+/// then all blocks are freed at once
+/// Data that lives as long as a project (nodes, edges, resolutions) costs no malloc each, and no free at the end
+/// @Warning destructors aren't called by the arena, only trivially destructible objects or containers that use an
+/// Arena_Allocator (their deallocations do nothing) go in it, and they have to be destroyed before the arena
+/// @Warning not thread safe, each thread uses its own arena
+class Arena
+{
+public:
+	struct Stats
+	{
+		size_t	nb_allocations = 0;
+		size_t	nb_blocks = 0;
+		size_t	used_bytes = 0;			// Allocated from blocks (the padding is included)
+		size_t	reserved_bytes = 0;		// Allocated blocks
+		size_t	high_water_mark = 0;	// Highest reserved_bytes, kept by release
+	};
+
+	Arena() = default;
+	Arena(const Arena&) = delete;
+	~Arena() { release(); }
+
+	Arena&	operator=(const Arena&) = delete;
+
+	/// @Warning alignment is at most alignof(std::max_align_t)
+	void*			allocate(size_t size, size_t alignment);
+
+	/// Uninitialized array of count objects
+	template<typename T>
+	T*				allocate(size_t count) { return static_cast<T*>(allocate(count * sizeof(T), alignof(T))); }
+
+	/// Free all blocks
+	void			release();
+
+	const Stats&	stats() const { return m_stats; }
+
+private:
+	static constexpr size_t	block_size = 64 * 1024;
+
+	std::vector<std::unique_ptr<char[]>>	m_blocks;
+	size_t									m_block_used = block_size;	// Used bytes of the last block
+	Stats									m_stats;
+};
+
+/// Allocator of standard containers that takes memory from an Arena, deallocate does nothing
+template<typename T>
+class Arena_Allocator
+{
+public:
+	using value_type = T;
+
+	explicit Arena_Allocator(Arena& arena) : m_arena(&arena) {}
+	template<typename U>
+	Arena_Allocator(const Arena_Allocator<U>& other) : m_arena(other.arena()) {}
+
+	T*		allocate(size_t count) { return m_arena->allocate<T>(count); }
+	void	deallocate(T*, size_t) {}
+
+	Arena*	arena() const { return m_arena; }
+
+	template<typename U>
+	bool	operator==(const Arena_Allocator<U>& other) const { return m_arena == other.arena(); }
+	template<typename U>
+	bool	operator!=(const Arena_Allocator<U>& other) const { return m_arena != other.arena(); }
+
+private:
+	Arena*	m_arena;
+};
+
+/// Return the peak memory used by the process (resident set size) in bytes, or 0 if it isn't available
+size_t	peak_memory_usage();
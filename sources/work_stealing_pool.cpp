@@ -0,0 +1,127 @@
+#include "work_stealing_pool.hpp"
+
+#include <algorithm>
+
+static thread_local const Work_Stealing_Pool*	current_pool = nullptr;
+static thread_local size_t						current_index = 0;
+
+Work_Stealing_Pool::Work_Stealing_Pool(size_t nb_threads)
+{
+	if (nb_threads == 0) {
+		nb_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	}
+
+	for (size_t i = 0; i < nb_threads; i++) {
+		m_queues.push_back(std::make_unique<Queue>());
+	}
+	for (size_t i = 0; i < nb_threads; i++) {
+		m_threads.emplace_back([this, i]() { work(i); });
+	}
+}
+
+Work_Stealing_Pool::~Work_Stealing_Pool()
+{
+	{
+		std::lock_guard<std::mutex>	lock(m_mutex);
+
+		m_stop = true;
+	}
+	m_work_available.notify_all();
+	for (std::thread& thread : m_threads) {
+		thread.join();
+	}
+}
+
+size_t Work_Stealing_Pool::current_thread_index()
+{
+	return current_index;
+}
+
+void Work_Stealing_Pool::submit(Task task)
+{
+	size_t	queue_index = current_pool == this ? current_index : m_next_queue++ % m_queues.size();
+
+	m_nb_pending_tasks++;
+	{
+		std::lock_guard<std::mutex>	lock(m_queues[queue_index]->mutex);
+
+		m_queues[queue_index]->tasks.push_back(std::move(task));
+	}
+	{
+		std::lock_guard<std::mutex>	lock(m_mutex);	// @Warning the counter is updated under the lock to not miss the wake up of a thread
+
+		m_nb_queued_tasks++;
+	}
+	m_work_available.notify_one();
+}
+
+void Work_Stealing_Pool::wait()
+{
+	std::unique_lock<std::mutex>	lock(m_mutex);
+
+	m_work_done.wait(lock, [this]() { return m_nb_pending_tasks == 0; });
+}
+
+bool Work_Stealing_Pool::take(size_t thread_index, Task& task)
+{
+	// The most recent task of its own queue
+	{
+		Queue&						queue = *m_queues[thread_index];
+		std::lock_guard<std::mutex>	lock(queue.mutex);
+
+		if (queue.tasks.empty() == false)
+		{
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+			return true;
+		}
+	}
+
+	// The oldest task of another queue
+	for (size_t i = 1; i < m_queues.size(); i++)
+	{
+		Queue&						queue = *m_queues[(thread_index + i) % m_queues.size()];
+		std::lock_guard<std::mutex>	lock(queue.mutex);
+
+		if (queue.tasks.empty() == false)
+		{
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void Work_Stealing_Pool::work(size_t thread_index)
+{
+	current_pool = this;
+	current_index = thread_index;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex>	lock(m_mutex);
+
+			m_work_available.wait(lock, [this]() { return m_stop || m_nb_queued_tasks > 0; });
+			if (m_stop) {
+				return;
+			}
+			m_nb_queued_tasks--;	// Reserve a task, it is in one of the queues
+		}
+
+		Task	task;
+
+		while (take(thread_index, task) == false) {
+			std::this_thread::yield();	// @Warning the reserved task is being pushed by submit
+		}
+		task();
+
+		if (--m_nb_pending_tasks == 0)
+		{
+			std::lock_guard<std::mutex>	lock(m_mutex);
+
+			m_work_done.notify_all();
+		}
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Pool of threads with a queue of tasks per thread
+/// A thread runs the last task of its own queue (the most recent one, its data are still in cache), when its queue is
+/// empty it steals the first task of another queue (the oldest one, it is the most likely to submit many other tasks)
+/// Tasks submitted by a task of the pool go to the queue of its thread, the other ones are spread over all queues
+class Work_Stealing_Pool
+{
+public:
+	using Task = std::function<void()>;
+
+	/// 0 for the number of hardware threads
+	explicit Work_Stealing_Pool(size_t nb_threads = 0);
+	~Work_Stealing_Pool();
+
+	Work_Stealing_Pool(const Work_Stealing_Pool&) = delete;
+	Work_Stealing_Pool&	operator=(const Work_Stealing_Pool&) = delete;
+
+	void	submit(Task task);
+
+	/// Wait until all submitted tasks are done, including the tasks they submit
+	void	wait();
+
+	size_t	nb_threads() const { return m_threads.size(); }
+
+	/// Return the index of the thread of the pool that runs the current task (0 to nb_threads() - 1)
+	/// !!! Warning only valid in a task
+	static size_t	current_thread_index();
+
+private:
+	struct Queue
+	{
+		std::mutex			mutex;
+		std::deque<Task>	tasks;
+	};
+
+	bool	take(size_t thread_index, Task& task);
+	void	work(size_t thread_index);
+
+	std::vector<std::unique_ptr<Queue>>	m_queues;	// By thread
+	std::vector<std::thread>			m_threads;
+	std::mutex							m_mutex;
+	std::condition_variable				m_work_available;
+	std::condition_variable				m_work_done;
+	std::atomic<size_t>					m_nb_queued_tasks{0};
+	std::atomic<size_t>					m_nb_pending_tasks{0};	// Queued or running
+	std::atomic<size_t>					m_next_queue{0};		// For tasks submitted from outside of the pool
+	bool								m_stop = false;
+};